@@ -167,6 +167,9 @@ def generate_sql_schema(table: dict) -> str:
 def generate_sql_file(json_data: dict) -> str:
     code = "pub const DATABASE_SCHEMA: &str = r###\""
     for table in json_data["tables"]:
+        # "sqlite": false tables are packets stored elsewhere, vulkan_event goes to the event store
+        if not table.get("sqlite", True):
+            continue
         code += generate_sql_schema(table)
         code += "\n"
     code += "\"###;\n\n"
@@ -0,0 +1,476 @@
+//! Headless benchmark of the collector ingest pipeline.
+//!
+//! Synthetic packet streams are generated from schema.json, so every table the layer can send is
+//! covered without touching this file. Two stages are measured:
+//! - decode: `Packet::deserialize` alone over an in-memory stream,
+//! - pipeline: TCP accept, `handle_client`, the mpsc channel and the batched writer, end to end.
+//!
+//! Results are printed as JSON on stdout, and written to `--output` when given.
+//!
+//! cargo bench --bench ingest -- --connections 4 --packets 50000 --rate 0 \
+//!     --mix vulkan_event=85,memory_usage=5,host_memory_usage=4,queue_activity=5,frame_information=1
+
+use app_lib::bindings::Packet;
+use app_lib::collector::{self, IngestMetrics};
+use app_lib::event_store::EventStoreWriter;
+use r2d2::Pool;
+use r2d2_sqlite::SqliteConnectionManager;
+use serde_json::{json, Value};
+use std::io::Write;
+use std::net::{TcpListener, TcpStream};
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicBool, AtomicI64, Ordering};
+use std::sync::{mpsc, Arc};
+use std::thread;
+use std::time::{Duration, Instant};
+
+const DEFAULT_MIX: &str = "vulkan_event=85,memory_usage=5,host_memory_usage=4,queue_activity=5,frame_information=1";
+// Packets per synthetic frame, frame numbers drive the event store zone maps
+const PACKETS_PER_FRAME: u64 = 200;
+
+struct Config {
+    connections: usize,
+    packets: usize,
+    rate: u64,
+    mix: Vec<(String, u32)>,
+    seed: u64,
+    output: Option<PathBuf>,
+    keep: bool,
+}
+
+impl Config {
+    fn parse() -> Result<Self, String> {
+        let mut config = Config {
+            connections: 4,
+            packets: 50_000,
+            rate: 0,
+            mix: parse_mix(DEFAULT_MIX)?,
+            seed: 0x5eed,
+            output: None,
+            keep: false,
+        };
+        let mut args = std::env::args().skip(1);
+        while let Some(arg) = args.next() {
+            let mut value = || args.next().ok_or(format!("Missing value for {}", arg));
+            match arg.as_str() {
+                "--connections" => config.connections = value()?.parse().map_err(|e| format!("--connections: {}", e))?,
+                "--packets" => config.packets = value()?.parse().map_err(|e| format!("--packets: {}", e))?,
+                "--rate" => config.rate = value()?.parse().map_err(|e| format!("--rate: {}", e))?,
+                "--mix" => config.mix = parse_mix(&value()?)?,
+                "--seed" => config.seed = value()?.parse().map_err(|e| format!("--seed: {}", e))?,
+                "--output" => config.output = Some(PathBuf::from(value()?)),
+                "--keep" => config.keep = true,
+                // Added by cargo bench
+                "--bench" => {}
+                _ => return Err(format!("Unknown argument {}", arg)),
+            }
+        }
+        if config.connections == 0 || config.packets == 0 {
+            return Err("--connections and --packets must be positive".into());
+        }
+        Ok(config)
+    }
+}
+
+fn parse_mix(mix: &str) -> Result<Vec<(String, u32)>, String> {
+    mix.split(',')
+        .map(|entry| {
+            let (table, weight) = entry.split_once('=').ok_or(format!("Invalid mix entry '{}', expected table=weight", entry))?;
+            let weight = weight.parse().map_err(|e| format!("Invalid weight for {}: {}", table, e))?;
+            Ok((table.to_string(), weight))
+        })
+        .collect()
+}
+
+// -----------------------------------------------------------------------------
+// Synthetic packets
+// -----------------------------------------------------------------------------
+
+#[derive(Clone, Copy)]
+enum ColumnKind {
+    I32,
+    I64,
+    Str,
+}
+
+enum ColumnValue {
+    Zero,
+    Unique,
+    Frame,
+    Timestamp,
+    Parameters,
+    Name,
+    Random,
+}
+
+struct Column {
+    kind: ColumnKind,
+    value: ColumnValue,
+}
+
+struct Table {
+    name: String,
+    packet_index: u32,
+    columns: Vec<Column>,
+}
+
+fn load_schema(path: &Path) -> Result<Vec<Table>, String> {
+    let schema: Value = serde_json::from_str(&std::fs::read_to_string(path).map_err(|e| format!("{}: {}", path.display(), e))?)
+        .map_err(|e| format!("{}: {}", path.display(), e))?;
+    let tables = schema["tables"].as_array().ok_or("schema.json has no tables")?;
+
+    let mut result = Vec::new();
+    // Packet type indices follow the table order, like generate_bindings.py
+    for (packet_index, table) in tables.iter().enumerate() {
+        let mut columns = Vec::new();
+        for column in table["columns"].as_array().ok_or("Table without columns")? {
+            let name = column["name"].as_str().unwrap_or_default();
+            let kind = match column["type"].as_str() {
+                Some("i32") => ColumnKind::I32,
+                Some("i64") => ColumnKind::I64,
+                Some("str") => ColumnKind::Str,
+                other => return Err(format!("Unsupported column type {:?}", other)),
+            };
+            let primary_key = column["primary_key"].as_bool().unwrap_or(false);
+            let autoincrement = column["autoincrement"].as_bool().unwrap_or(false);
+            let value = if autoincrement {
+                ColumnValue::Zero
+            } else if primary_key {
+                ColumnValue::Unique
+            } else if name.starts_with("frame") {
+                ColumnValue::Frame
+            } else if name == "timestamp" || name.ends_with("_at") {
+                ColumnValue::Timestamp
+            } else if name == "parameters" {
+                ColumnValue::Parameters
+            } else if matches!(kind, ColumnKind::Str) {
+                ColumnValue::Name
+            } else {
+                ColumnValue::Random
+            };
+            columns.push(Column { kind, value });
+        }
+        result.push(Table {
+            name: table["name"].as_str().unwrap_or_default().to_string(),
+            packet_index: packet_index as u32,
+            columns,
+        });
+    }
+    Ok(result)
+}
+
+struct Generator<'a> {
+    state: u64,
+    weighted: Vec<(&'a Table, u32)>,
+    total_weight: u32,
+    unique: &'a AtomicI64,
+    packet_count: u64,
+}
+
+impl<'a> Generator<'a> {
+    fn new(tables: &'a [Table], mix: &[(String, u32)], seed: u64, unique: &'a AtomicI64) -> Result<Self, String> {
+        let mut weighted = Vec::new();
+        for (name, weight) in mix {
+            let table = tables.iter().find(|table| &table.name == name).ok_or(format!("Unknown table '{}' in mix", name))?;
+            if *weight > 0 {
+                weighted.push((table, *weight));
+            }
+        }
+        let total_weight = weighted.iter().map(|(_, weight)| weight).sum();
+        if total_weight == 0 {
+            return Err("The mix is empty".into());
+        }
+        Ok(Self { state: seed | 1, weighted, total_weight, unique, packet_count: 0 })
+    }
+
+    // xorshift64*, good enough for synthetic data and keeps the bench free of dependencies
+    fn next(&mut self) -> u64 {
+        self.state ^= self.state >> 12;
+        self.state ^= self.state << 25;
+        self.state ^= self.state >> 27;
+        self.state.wrapping_mul(0x2545_f491_4f6c_dd1d)
+    }
+
+    /// Appends one length-prefixed packet, framed like the layer sends it.
+    fn write_frame(&mut self, frame: &mut Vec<u8>) {
+        let mut pick = (self.next() % self.total_weight as u64) as u32;
+        let mut table = self.weighted[0].0;
+        for (candidate, weight) in &self.weighted {
+            if pick < *weight {
+                table = *candidate;
+                break;
+            }
+            pick -= weight;
+        }
+
+        let start = frame.len();
+        frame.extend(&0u32.to_be_bytes());
+        frame.extend(&table.packet_index.to_be_bytes());
+        let frame_number = (self.packet_count / PACKETS_PER_FRAME) as i64;
+        let timestamp = 1_700_000_000_000_000 + self.packet_count as i64 * 10;
+        for column in &table.columns {
+            let value = match column.value {
+                ColumnValue::Zero => 0,
+                ColumnValue::Unique => self.unique.fetch_add(1, Ordering::Relaxed),
+                ColumnValue::Frame => frame_number,
+                ColumnValue::Timestamp => timestamp,
+                ColumnValue::Random => (self.next() >> 33) as i64,
+                ColumnValue::Parameters => {
+                    let length = 64 + (self.next() % 448) as usize;
+                    let mut parameters = String::with_capacity(length);
+                    parameters.push_str("{\"pCreateInfo\":{\"size\":");
+                    while parameters.len() + 1 < length {
+                        parameters.push(char::from(b'0' + (self.next() % 10) as u8));
+                    }
+                    parameters.push('}');
+                    write_str(frame, &parameters);
+                    continue;
+                }
+                ColumnValue::Name => {
+                    write_str(frame, &format!("vkSyntheticCommand{:02}", self.next() % 48));
+                    continue;
+                }
+            };
+            match column.kind {
+                ColumnKind::I32 => frame.extend(&(value as i32).to_be_bytes()),
+                ColumnKind::I64 => frame.extend(&value.to_be_bytes()),
+                ColumnKind::Str => write_str(frame, &value.to_string()),
+            }
+        }
+        let length = (frame.len() - start - 4) as u32;
+        frame[start..start + 4].copy_from_slice(&length.to_be_bytes());
+        self.packet_count += 1;
+    }
+}
+
+fn write_str(frame: &mut Vec<u8>, value: &str) {
+    frame.extend(&(value.len() as u32).to_be_bytes());
+    frame.extend(value.as_bytes());
+}
+
+/// Splits a stream back into its packets, without the length prefix.
+fn packets(stream: &[u8]) -> impl Iterator<Item = &[u8]> {
+    let mut offset = 0;
+    std::iter::from_fn(move || {
+        if offset >= stream.len() {
+            return None;
+        }
+        let length = u32::from_be_bytes(stream[offset..offset + 4].try_into().unwrap()) as usize;
+        let packet = &stream[offset + 4..offset + 4 + length];
+        offset += 4 + length;
+        Some(packet)
+    })
+}
+
+// -----------------------------------------------------------------------------
+// Stages
+// -----------------------------------------------------------------------------
+
+fn bench_decode(stream: &[u8], packet_count: usize) -> Value {
+    let started_at = Instant::now();
+    let mut failures = 0;
+    for packet in packets(stream) {
+        match Packet::deserialize(packet) {
+            Some(packet) => drop(std::hint::black_box(packet)),
+            None => failures += 1,
+        }
+    }
+    let seconds = started_at.elapsed().as_secs_f64();
+    json!({
+        "packets": packet_count,
+        "bytes": stream.len(),
+        "failures": failures,
+        "seconds": seconds,
+        "packets_per_second": packet_count as f64 / seconds,
+        "megabytes_per_second": stream.len() as f64 / seconds / 1e6,
+        "nanoseconds_per_packet": seconds * 1e9 / packet_count as f64,
+    })
+}
+
+fn send_stream(address: std::net::SocketAddr, stream: &[u8], rate: u64) {
+    let mut socket = TcpStream::connect(address).expect("Could not connect to the collector");
+    socket.set_nodelay(true).ok();
+    let started_at = Instant::now();
+    // One write per packet, like the layer
+    for (index, packet) in packets(stream).enumerate() {
+        if rate > 0 {
+            let due = started_at + Duration::from_secs_f64(index as f64 / rate as f64);
+            if let Some(wait) = due.checked_duration_since(Instant::now()) {
+                thread::sleep(wait);
+            }
+        }
+        let mut frame = Vec::with_capacity(4 + packet.len());
+        frame.extend(&(packet.len() as u32).to_be_bytes());
+        frame.extend(packet);
+        socket.write_all(&frame).expect("Could not send packet");
+    }
+}
+
+fn bench_pipeline(config: &Config, streams: &[Vec<u8>], directory: &Path) -> Value {
+    let database_path = directory.join("bench.vmi");
+    let event_store_path = directory.join("bench.vmi.events");
+    let pool = Pool::new(SqliteConnectionManager::file(&database_path)).expect("Could not create a connection pool");
+    collector::init_database(&pool);
+    let event_store = EventStoreWriter::create(&event_store_path).expect("Could not create the event store");
+    let storage_before = directory_size(directory);
+
+    let metrics = Arc::new(IngestMetrics::default());
+    let (packet_tx, packet_rx) = mpsc::channel::<Packet>();
+    let listener = TcpListener::bind("127.0.0.1:0").expect("Could not bind the collector socket");
+    let address = listener.local_addr().unwrap();
+    let started_at = Instant::now();
+
+    let writer_metrics = metrics.clone();
+    let writer_pool = pool.clone();
+    let writer = thread::spawn(move || collector::run_writer(writer_pool, event_store, packet_rx, &writer_metrics));
+
+    let connections = config.connections;
+    let accept_metrics = metrics.clone();
+    let acceptor = thread::spawn(move || {
+        let readers: Vec<_> = (0..connections)
+            .map(|_| {
+                let (stream, _) = listener.accept().expect("Could not accept a connection");
+                let packet_tx = packet_tx.clone();
+                let metrics = accept_metrics.clone();
+                thread::spawn(move || collector::handle_client(stream, packet_tx, &metrics))
+            })
+            .collect();
+        // The writer returns once the last reader drops its sender
+        drop(packet_tx);
+        for reader in readers {
+            reader.join().unwrap();
+        }
+    });
+
+    let done = Arc::new(AtomicBool::new(false));
+    let sampler_metrics = metrics.clone();
+    let sampler_done = done.clone();
+    let sampler = thread::spawn(move || {
+        let (mut max_backlog, mut backlog_sum, mut samples) = (0u64, 0u64, 0u64);
+        while !sampler_done.load(Ordering::Relaxed) {
+            let backlog = sampler_metrics.backlog();
+            max_backlog = max_backlog.max(backlog);
+            backlog_sum += backlog;
+            samples += 1;
+            thread::sleep(Duration::from_millis(5));
+        }
+        (max_backlog, backlog_sum as f64 / samples.max(1) as f64)
+    });
+
+    thread::scope(|scope| {
+        for stream in streams {
+            scope.spawn(move || send_stream(address, stream, config.rate));
+        }
+    });
+    let sent_at = started_at.elapsed().as_secs_f64();
+    acceptor.join().unwrap();
+    writer.join().unwrap();
+    let seconds = started_at.elapsed().as_secs_f64();
+    done.store(true, Ordering::Relaxed);
+    let (max_backlog, mean_backlog) = sampler.join().unwrap();
+
+    let packets_sent = (config.packets * config.connections) as u64;
+    let bytes_sent: usize = streams.iter().map(Vec::len).sum();
+    let commits = metrics.commits.load(Ordering::Relaxed);
+    let storage_after = directory_size(directory);
+    let storage_growth = storage_after.saturating_sub(storage_before);
+    json!({
+        "packets_sent": packets_sent,
+        "packets_written": metrics.packets_written.load(Ordering::Relaxed),
+        "decode_failures": metrics.decode_failures.load(Ordering::Relaxed),
+        "send_seconds": sent_at,
+        "seconds": seconds,
+        "packets_per_second": packets_sent as f64 / seconds,
+        "megabytes_per_second": bytes_sent as f64 / seconds / 1e6,
+        "backlog": {
+            "max": max_backlog,
+            "mean": mean_backlog,
+        },
+        "commits": commits,
+        "commit_latency_ns": {
+            "mean": metrics.commit_nanos.load(Ordering::Relaxed) / commits.max(1),
+            "p50": metrics.commit_latency_percentile(50.0),
+            "p99": metrics.commit_latency_percentile(99.0),
+            "max": metrics.max_commit_nanos.load(Ordering::Relaxed),
+        },
+        "storage": {
+            "database_bytes": file_size(&database_path) + file_size(&database_path.with_extension("vmi-wal")) + file_size(&database_path.with_extension("vmi-journal")),
+            "event_store_bytes": directory_size(&event_store_path),
+            "growth_bytes": storage_growth,
+            "bytes_per_packet": storage_growth as f64 / packets_sent as f64,
+            "wire_bytes_per_packet": bytes_sent as f64 / packets_sent as f64,
+        },
+    })
+}
+
+fn file_size(path: &Path) -> u64 {
+    std::fs::metadata(path).map(|metadata| metadata.len()).unwrap_or(0)
+}
+
+fn directory_size(path: &Path) -> u64 {
+    let Ok(entries) = std::fs::read_dir(path) else {
+        return 0;
+    };
+    entries
+        .filter_map(Result::ok)
+        .map(|entry| match entry.file_type() {
+            Ok(file_type) if file_type.is_dir() => directory_size(&entry.path()),
+            _ => file_size(&entry.path()),
+        })
+        .sum()
+}
+
+fn main() {
+    let config = Config::parse().unwrap_or_else(|e| {
+        eprintln!("{}", e);
+        std::process::exit(2);
+    });
+    let schema_path = Path::new(env!("CARGO_MANIFEST_DIR")).join("../../schema.json");
+    let tables = load_schema(&schema_path).unwrap_or_else(|e| {
+        eprintln!("Could not load the schema: {}", e);
+        std::process::exit(2);
+    });
+
+    let unique = AtomicI64::new(0);
+    let streams: Vec<Vec<u8>> = (0..config.connections)
+        .map(|connection| {
+            let mut generator = Generator::new(&tables, &config.mix, config.seed.wrapping_add(connection as u64), &unique).unwrap_or_else(|e| {
+                eprintln!("{}", e);
+                std::process::exit(2);
+            });
+            let mut stream = Vec::new();
+            for _ in 0..config.packets {
+                generator.write_frame(&mut stream);
+            }
+            stream
+        })
+        .collect();
+
+    let directory = std::env::temp_dir().join(format!("vmi-ingest-bench-{}", std::process::id()));
+    std::fs::create_dir_all(&directory).expect("Could not create the benchmark directory");
+
+    let decode = bench_decode(&streams[0], config.packets);
+    let pipeline = bench_pipeline(&config, &streams, &directory);
+    let report = json!({
+        "config": {
+            "connections": config.connections,
+            "packets_per_connection": config.packets,
+            "rate_per_connection": config.rate,
+            "mix": config.mix.iter().map(|(table, weight)| (table.clone(), json!(weight))).collect::<serde_json::Map<_, _>>(),
+            "batch_size": collector::BATCH_SIZE,
+        },
+        "decode": decode,
+        "pipeline": pipeline,
+    });
+
+    let report = serde_json::to_string_pretty(&report).unwrap();
+    println!("{}", report);
+    if let Some(output) = &config.output {
+        std::fs::write(output, &report).expect("Could not write the report");
+    }
+    if !config.keep {
+        std::fs::remove_dir_all(&directory).ok();
+    } else {
+        eprintln!("Capture kept in {}", directory.display());
+    }
+}
@@ -0,0 +1,341 @@
+use crate::bindings::{self, Packet};
+use crate::control::ControlChannel;
+use crate::event_store::EventStoreWriter;
+use r2d2::Pool;
+use r2d2_sqlite::SqliteConnectionManager;
+use rusqlite::{params, Transaction};
+use std::io::{self, BufReader, Read};
+use std::net::{TcpListener, TcpStream};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{mpsc, Arc};
+use std::thread;
+use std::time::{Duration, Instant};
+
+// Upper bound on a framed packet, anything larger means the stream is out of sync
+pub const MAX_PACKET_SIZE: usize = 64 * 1024 * 1024;
+// Packets written per SQLite transaction
+pub const BATCH_SIZE: usize = 100;
+
+const COMMIT_LATENCY_BUCKETS: usize = 64;
+
+/// Counters of the ingest pipeline, updated with relaxed atomics so they can be read while it runs.
+pub struct IngestMetrics {
+    pub packets_received: AtomicU64,
+    pub bytes_received: AtomicU64,
+    pub decode_failures: AtomicU64,
+    pub packets_written: AtomicU64,
+    pub commits: AtomicU64,
+    pub commit_nanos: AtomicU64,
+    pub max_commit_nanos: AtomicU64,
+    // Commit latencies by power of two nanoseconds
+    commit_latency_histogram: [AtomicU64; COMMIT_LATENCY_BUCKETS],
+}
+
+impl Default for IngestMetrics {
+    fn default() -> Self {
+        Self {
+            packets_received: AtomicU64::new(0),
+            bytes_received: AtomicU64::new(0),
+            decode_failures: AtomicU64::new(0),
+            packets_written: AtomicU64::new(0),
+            commits: AtomicU64::new(0),
+            commit_nanos: AtomicU64::new(0),
+            max_commit_nanos: AtomicU64::new(0),
+            commit_latency_histogram: std::array::from_fn(|_| AtomicU64::new(0)),
+        }
+    }
+}
+
+impl IngestMetrics {
+    /// Packets decoded and queued on the channel but not committed yet.
+    pub fn backlog(&self) -> u64 {
+        let received = self.packets_received.load(Ordering::Relaxed);
+        let written = self.packets_written.load(Ordering::Relaxed);
+        received.saturating_sub(written)
+    }
+
+    /// Upper bound, in nanoseconds, of the commit latency under which `percentile` of the commits fall.
+    pub fn commit_latency_percentile(&self, percentile: f64) -> u64 {
+        let counts: Vec<u64> = self.commit_latency_histogram.iter().map(|count| count.load(Ordering::Relaxed)).collect();
+        let total: u64 = counts.iter().sum();
+        if total == 0 {
+            return 0;
+        }
+        let rank = ((total as f64) * percentile / 100.0).ceil().max(1.0) as u64;
+        let mut seen = 0;
+        for (bucket, count) in counts.iter().enumerate() {
+            seen += count;
+            if seen >= rank {
+                return 1u64 << bucket;
+            }
+        }
+        u64::MAX
+    }
+
+    fn record_commit(&self, packets: usize, latency: Duration) {
+        let nanos = latency.as_nanos().min(u64::MAX as u128) as u64;
+        self.packets_written.fetch_add(packets as u64, Ordering::Relaxed);
+        self.commits.fetch_add(1, Ordering::Relaxed);
+        self.commit_nanos.fetch_add(nanos, Ordering::Relaxed);
+        self.max_commit_nanos.fetch_max(nanos, Ordering::Relaxed);
+        let bucket = (u64::BITS - nanos.leading_zeros()) as usize;
+        self.commit_latency_histogram[bucket.min(COMMIT_LATENCY_BUCKETS - 1)].fetch_add(1, Ordering::Relaxed);
+    }
+}
+
+pub fn init_database(pool: &Pool<SqliteConnectionManager>) {
+    let conn = pool
+        .get()
+        .expect("Could not get a connection from the pool");
+    conn.execute_batch(bindings::DATABASE_SCHEMA)
+        .expect("Failed to create database schema");
+}
+
+/// Accepts the layer connections, each one gets a reader thread and a control handle.
+pub fn serve(listener: TcpListener, packet_tx: mpsc::Sender<Packet>, control: Arc<ControlChannel>, metrics: Arc<IngestMetrics>) {
+    for stream in listener.incoming() {
+        match stream {
+            Ok(stream) => {
+                println!("New connection: {}", stream.peer_addr().unwrap());
+                let control_client = match stream.try_clone() {
+                    Ok(control_stream) => Some(control.register(control_stream)),
+                    Err(e) => {
+                        eprintln!("Could not open the control channel: {}", e);
+                        None
+                    }
+                };
+                let packet_tx = packet_tx.clone();
+                let metrics = metrics.clone();
+                let control = control.clone();
+                thread::spawn(move || {
+                    handle_client(stream, packet_tx, &metrics);
+                    if let Some(control_client) = control_client {
+                        control.unregister(control_client);
+                    }
+                });
+            }
+            Err(err) => println!("Connection failed due to {:?}", err)
+        }
+    }
+}
+
+pub fn handle_client(stream: TcpStream, packet_tx: mpsc::Sender<Packet>, metrics: &IngestMetrics) {
+    // Every packet is prefixed by its big endian u32 length
+    let mut reader = BufReader::new(stream);
+    let mut length = [0; 4];
+    let mut buffer = Vec::new();
+    loop {
+        match reader.read_exact(&mut length) {
+            Ok(()) => {}
+            Err(e) if e.kind() == io::ErrorKind::UnexpectedEof => break, // Connection closed
+            Err(e) => {
+                eprintln!("Error reading from stream: {}", e);
+                break;
+            }
+        }
+        let length = u32::from_be_bytes(length) as usize;
+        if length > MAX_PACKET_SIZE {
+            eprintln!("Invalid packet length {}, closing the connection", length);
+            break;
+        }
+        buffer.resize(length, 0);
+        if let Err(e) = reader.read_exact(&mut buffer) {
+            eprintln!("Error reading from stream: {}", e);
+            break;
+        }
+
+        let packet = Packet::deserialize(&buffer);
+        if packet.is_none() {
+            eprintln!("Failed to deserialize packet");
+            metrics.decode_failures.fetch_add(1, Ordering::Relaxed);
+            continue;
+        }
+        metrics.packets_received.fetch_add(1, Ordering::Relaxed);
+        metrics.bytes_received.fetch_add(4 + length as u64, Ordering::Relaxed);
+        packet_tx.send(packet.unwrap()).unwrap_or_else(|e| {
+            eprintln!("Failed to send packet to main thread: {}", e);
+        });
+    }
+}
+
+/// Writes the packets in batches of BATCH_SIZE, vulkan_event rows go to the event store and the
+/// others to SQLite. Returns once every sender is gone and the last batch is written.
+pub fn run_writer(pool: Pool<SqliteConnectionManager>, mut event_store: EventStoreWriter, packet_rx: mpsc::Receiver<Packet>, metrics: &IngestMetrics) {
+    let mut buffer: Vec<Packet> = Vec::new();
+    let mut disconnected = false;
+
+    while !disconnected {
+        loop {
+            match packet_rx.recv_timeout(Duration::from_millis(10)) {
+                Ok(packet) => {
+                    buffer.push(packet);
+                    if buffer.len() >= BATCH_SIZE {
+                        break;
+                    }
+                }
+                Err(mpsc::RecvTimeoutError::Timeout) => break,
+                Err(mpsc::RecvTimeoutError::Disconnected) => {
+                    disconnected = true;
+                    break;
+                }
+            }
+        }
+
+        if !buffer.is_empty() {
+            let started_at = Instant::now();
+            let mut conn = pool
+                .get()
+                .expect("Impossible de récupérer une connexion du pool");
+            let tx = conn
+                .transaction()
+                .expect("Échec du démarrage de la transaction");
+
+            for packet in &buffer {
+                write_packet(&tx, &mut event_store, packet);
+            }
+
+            tx.commit().expect("Could not commit transaction");
+            metrics.record_commit(buffer.len(), started_at.elapsed());
+            buffer.clear();
+        }
+
+        event_store
+            .seal_if_older_than(Duration::from_secs(1))
+            .expect("Could not seal event chunk");
+    }
+
+    event_store.seal().expect("Could not seal event chunk");
+}
+
+fn write_packet(tx: &Transaction, event_store: &mut EventStoreWriter, packet: &Packet) {
+    match packet {
+        Packet::VulkanEvent(vulkan_event) => {
+            event_store.append(
+                vulkan_event.timestamp,
+                vulkan_event.frame_number,
+                &vulkan_event.function_name,
+                &vulkan_event.parameters,
+                vulkan_event.result_code,
+                vulkan_event.thread_id,
+            ).expect("Could not append Vulkan event");
+        }
+        Packet::MemoryUsage(memory_usage_event) => {
+            tx.execute(
+                "INSERT INTO memory_usage (device_memory, frame_index_allocated, allocated_at, allocation_size, frame_index_deallocated, deallocated_at)
+                VALUES (?1, ?2, ?3, ?4, ?5, ?6)",
+                params![
+                    memory_usage_event.device_memory,
+                    memory_usage_event.frame_index_allocated,
+                    memory_usage_event.allocated_at,
+                    memory_usage_event.allocation_size,
+                    memory_usage_event.frame_index_deallocated,
+                    memory_usage_event.deallocated_at,
+                ],
+            ).expect("Could not insert Memory usage event");
+        }
+        Packet::FrameInformation(frame_information) => {
+            tx.execute(
+                "INSERT INTO frame_information (frame_index, started_at)
+                VALUES (?1, ?2)",
+                params![
+                    frame_information.frame_index,
+                    frame_information.started_at,
+                ],
+            ).expect("Could not insert Frame information event");
+        }
+        Packet::HostMemoryUsage(host_memory_usage) => {
+            tx.execute(
+                "INSERT INTO host_memory_usage (frame_index, category, name, allocation_count, allocated_bytes, free_count, freed_bytes)
+                VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7)",
+                params![
+                    host_memory_usage.frame_index,
+                    host_memory_usage.category,
+                    host_memory_usage.name,
+                    host_memory_usage.allocation_count,
+                    host_memory_usage.allocated_bytes,
+                    host_memory_usage.free_count,
+                    host_memory_usage.freed_bytes,
+                ],
+            ).expect("Could not insert Host memory usage event");
+        }
+        Packet::QueueActivity(queue_activity) => {
+            tx.execute(
+                "INSERT INTO queue_activity (frame_index, function_name, queue, started_at, cpu_duration_ns, batch_count, command_buffer_count, wait_semaphore_count, signal_semaphore_count, is_stall, result_code)
+                VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10, ?11)",
+                params![
+                    queue_activity.frame_index,
+                    queue_activity.function_name,
+                    queue_activity.queue,
+                    queue_activity.started_at,
+                    queue_activity.cpu_duration_ns,
+                    queue_activity.batch_count,
+                    queue_activity.command_buffer_count,
+                    queue_activity.wait_semaphore_count,
+                    queue_activity.signal_semaphore_count,
+                    queue_activity.is_stall,
+                    queue_activity.result_code,
+                ],
+            ).expect("Could not insert Queue activity event");
+        }
+        Packet::FrameTiming(frame_timing) => {
+            tx.execute(
+                "INSERT INTO frame_timing (swapchain, first_frame_index, last_frame_index, frame_count, sent_at, min_us, p50_us, p95_us, p99_us, max_us)
+                VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10)",
+                params![
+                    frame_timing.swapchain,
+                    frame_timing.first_frame_index,
+                    frame_timing.last_frame_index,
+                    frame_timing.frame_count,
+                    frame_timing.sent_at,
+                    frame_timing.min_us,
+                    frame_timing.p50_us,
+                    frame_timing.p95_us,
+                    frame_timing.p99_us,
+                    frame_timing.max_us,
+                ],
+            ).expect("Could not insert Frame timing event");
+        }
+        Packet::ObjectLeak(object_leak) => {
+            tx.execute(
+                "INSERT INTO object_leak (device, object_type, leaked_count, leaked_bytes, oldest_frame_index, frame_index)
+                VALUES (?1, ?2, ?3, ?4, ?5, ?6)",
+                params![
+                    object_leak.device,
+                    object_leak.object_type,
+                    object_leak.leaked_count,
+                    object_leak.leaked_bytes,
+                    object_leak.oldest_frame_index,
+                    object_leak.frame_index,
+                ],
+            ).expect("Could not insert Object leak event");
+        }
+        Packet::MemoryAdvice(memory_advice) => {
+            tx.execute(
+                "INSERT INTO memory_advice (frame_index, device, buffer_count, buffer_requested_bytes, buffer_size_padding_bytes, buffer_alignment_padding_bytes, image_count, image_bytes, image_alignment_padding_bytes, dedicated_preferred_count, dedicated_ignored_count, dedicated_ignored_bytes, allocation_count, allocated_bytes, unused_allocated_bytes, small_allocation_count, small_allocation_bytes, allocation_count_limit, peak_allocation_count, pressure_allocation_count)
+                VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10, ?11, ?12, ?13, ?14, ?15, ?16, ?17, ?18, ?19, ?20)",
+                params![
+                    memory_advice.frame_index,
+                    memory_advice.device,
+                    memory_advice.buffer_count,
+                    memory_advice.buffer_requested_bytes,
+                    memory_advice.buffer_size_padding_bytes,
+                    memory_advice.buffer_alignment_padding_bytes,
+                    memory_advice.image_count,
+                    memory_advice.image_bytes,
+                    memory_advice.image_alignment_padding_bytes,
+                    memory_advice.dedicated_preferred_count,
+                    memory_advice.dedicated_ignored_count,
+                    memory_advice.dedicated_ignored_bytes,
+                    memory_advice.allocation_count,
+                    memory_advice.allocated_bytes,
+                    memory_advice.unused_allocated_bytes,
+                    memory_advice.small_allocation_count,
+                    memory_advice.small_allocation_bytes,
+                    memory_advice.allocation_count_limit,
+                    memory_advice.peak_allocation_count,
+                    memory_advice.pressure_allocation_count,
+                ],
+            ).expect("Could not insert Memory advice event");
+        }
+    }
+}
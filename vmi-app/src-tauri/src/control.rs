@@ -0,0 +1,141 @@
+use std::io::Write;
+use std::net::{Shutdown, TcpStream};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex};
+use std::time::Duration;
+
+// Mirrors ControlOpcode in vmi-layer/Include/VMI/ControlMessage.hpp
+const SET_CAPTURE_CATEGORIES: u32 = 1;
+const SET_SAMPLING_RATE: u32 = 2;
+const REQUEST_SNAPSHOT: u32 = 3;
+
+const CONTROL_MESSAGE_SIZE: u32 = 16;
+
+// A layer whose receive thread is stuck stops reading, its socket buffer fills up
+const CONTROL_WRITE_TIMEOUT: Duration = Duration::from_millis(500);
+
+// Mirrors CaptureCategory in vmi-layer/Include/VMI/CaptureCategory.hpp, core cannot be toggled
+const CAPTURE_CATEGORIES: &[(&str, u32)] = &[
+    ("api_trace", 1 << 1),
+    ("memory", 1 << 2),
+    ("command_buffer", 1 << 3),
+    ("host_memory", 1 << 4),
+    ("submission", 1 << 5),
+    ("lifetime", 1 << 6),
+];
+
+/// Categories active when an application is launched without a choice, the ones that do not send
+/// rows per call. api_trace, command_buffer and submission are enabled through the control channel
+/// around the problem.
+pub const DEFAULT_ACTIVE_CATEGORIES: &[&str] = &["memory", "host_memory", "lifetime"];
+
+// Categories the layer publishes a snapshot of on REQUEST_SNAPSHOT, memory and host_memory
+const SNAPSHOT_CATEGORIES: u32 = (1 << 2) | (1 << 4);
+
+pub fn parse_capture_categories(names: &[String]) -> Result<u32, String> {
+    let mut flags = 0;
+    for name in names {
+        if name == "all" {
+            flags |= CAPTURE_CATEGORIES.iter().fold(0, |flags, (_, flag)| flags | flag);
+            continue;
+        }
+        match CAPTURE_CATEGORIES.iter().find(|(category, _)| category == name) {
+            Some((_, flag)) => flags |= flag,
+            None => return Err(format!("Unknown capture category '{}'", name)),
+        }
+    }
+    Ok(flags)
+}
+
+/// Same as parse_capture_categories, restricted to the categories that have a snapshot. "all" requests every snapshot.
+pub fn parse_snapshot_categories(names: &[String]) -> Result<u32, String> {
+    if names.iter().any(|name| name == "all") {
+        return Ok(SNAPSHOT_CATEGORIES);
+    }
+    let flags = parse_capture_categories(names)?;
+    let unsupported: Vec<&str> = CAPTURE_CATEGORIES.iter()
+        .filter(|(_, flag)| flags & flag & !SNAPSHOT_CATEGORIES != 0)
+        .map(|(category, _)| *category)
+        .collect();
+    if !unsupported.is_empty() {
+        return Err(format!("No snapshot available for the capture categories {}", unsupported.join(", ")));
+    }
+    Ok(flags)
+}
+
+pub type ControlClientId = u64;
+
+/// Write side of the sockets opened by the layers, used to send them control messages.
+/// Messages are framed like the packets: a big endian u32 length, then opcode, argument and value.
+#[derive(Default)]
+pub struct ControlChannel {
+    clients: Mutex<Vec<(ControlClientId, Arc<TcpStream>)>>,
+    next_client_id: AtomicU64,
+    // Keeps the messages of concurrent broadcasts from interleaving on a stream
+    broadcast_mutex: Mutex<()>,
+}
+
+impl ControlChannel {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    pub fn register(&self, stream: TcpStream) -> ControlClientId {
+        if let Err(e) = stream.set_write_timeout(Some(CONTROL_WRITE_TIMEOUT)) {
+            eprintln!("Failed to set the control write timeout: {}", e);
+        }
+        let id = self.next_client_id.fetch_add(1, Ordering::Relaxed);
+        self.clients.lock().unwrap().push((id, Arc::new(stream)));
+        id
+    }
+
+    /// Forgets a layer once its connection is closed, called by the reader thread of the connection.
+    pub fn unregister(&self, id: ControlClientId) {
+        self.clients.lock().unwrap().retain(|(client_id, _)| *client_id != id);
+    }
+
+    pub fn set_capture_categories(&self, categories: u32, enabled: bool) -> Result<usize, String> {
+        self.broadcast(SET_CAPTURE_CATEGORIES, categories, enabled as i64)
+    }
+
+    pub fn set_sampling_rate(&self, sampling_rate: u32) -> Result<usize, String> {
+        self.broadcast(SET_SAMPLING_RATE, 0, sampling_rate.max(1) as i64)
+    }
+
+    pub fn request_snapshot(&self, categories: u32) -> Result<usize, String> {
+        self.broadcast(REQUEST_SNAPSHOT, categories, 0)
+    }
+
+    /// Sends the message to every connected layer and returns how many received it.
+    /// Layers are forgotten when their connection closes, or here when the write fails or times out.
+    /// The writes happen outside of the client list lock, a stalled layer does not block registrations.
+    fn broadcast(&self, opcode: u32, argument: u32, value: i64) -> Result<usize, String> {
+        let mut message = Vec::with_capacity(4 + CONTROL_MESSAGE_SIZE as usize);
+        message.extend(&CONTROL_MESSAGE_SIZE.to_be_bytes());
+        message.extend(&opcode.to_be_bytes());
+        message.extend(&argument.to_be_bytes());
+        message.extend(&value.to_be_bytes());
+
+        let _broadcast = self.broadcast_mutex.lock().map_err(|e| format!("Failed to lock the control channel: {}", e))?;
+        let clients = self.clients.lock().map_err(|e| format!("Failed to lock the control channel: {}", e))?.clone();
+        let mut failed = Vec::new();
+        for (id, stream) in &clients {
+            if let Err(e) = (&**stream).write_all(&message) {
+                eprintln!("Dropping control client: {}", e);
+                // A message may have been cut short, the layer stops reading at the end of stream
+                let _ = stream.shutdown(Shutdown::Write);
+                failed.push(*id);
+            }
+        }
+
+        if !failed.is_empty() {
+            let mut clients = self.clients.lock().map_err(|e| format!("Failed to lock the control channel: {}", e))?;
+            clients.retain(|(id, _)| !failed.contains(id));
+        }
+        let received = clients.len() - failed.len();
+        if received == 0 {
+            return Err("No application connected".into());
+        }
+        Ok(received)
+    }
+}
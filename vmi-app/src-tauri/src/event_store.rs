@@ -0,0 +1,752 @@
+//! Column-oriented storage for `vulkan_event` rows.
+//!
+//! Full API traces produce far too many rows for SQLite, so the collector writes
+//! them into fixed-size chunks instead. Each chunk file holds one column per field:
+//! function names are dictionary-encoded, timestamps and frame numbers are
+//! delta-encoded varints, and the header keeps a min/max zone map so frame range
+//! queries can skip whole chunks. A histogram of the function ids of the chunk is
+//! written at seal time, so that counts over the chunks a range fully covers do not
+//! read their rows. Sealed chunks are read through memory maps.
+//!
+//! Layout of a directory:
+//!   functions.dict        u32 length + utf8 bytes, one entry per function id
+//!   chunk_000000.col      sealed chunk (written as .tmp then renamed)
+
+use memmap2::Mmap;
+use serde::Serialize;
+use std::collections::HashMap;
+use std::fs::{self, File, OpenOptions};
+use std::io::{self, Read, Write};
+use std::ops::RangeInclusive;
+use std::path::{Path, PathBuf};
+use std::time::{Duration, Instant};
+
+const CHUNK_CAPACITY: usize = 64 * 1024;
+const CHUNK_MAGIC: &[u8; 8] = b"VMICOL02";
+const COLUMN_COUNT: usize = 7;
+const HEADER_SIZE: usize = 8 + 4 + 4 + 4 + 4 * 8 + COLUMN_COUNT * 16;
+const DICTIONARY_FILE: &str = "functions.dict";
+
+const COLUMN_TIMESTAMP: usize = 0;
+const COLUMN_FRAME_NUMBER: usize = 1;
+const COLUMN_FUNCTION_ID: usize = 2;
+const COLUMN_RESULT_CODE: usize = 3;
+const COLUMN_THREAD_ID: usize = 4;
+const COLUMN_PARAMETERS: usize = 5;
+// (u32 function id, u32 row count) pairs, sorted by id
+const COLUMN_FUNCTION_HISTOGRAM: usize = 6;
+
+fn chunk_path(directory: &Path, index: u32) -> PathBuf {
+    directory.join(format!("chunk_{:06}.col", index))
+}
+
+fn write_varint(buffer: &mut Vec<u8>, value: i64) {
+    let mut zigzag = ((value << 1) ^ (value >> 63)) as u64;
+    while zigzag >= 0x80 {
+        buffer.push((zigzag as u8) | 0x80);
+        zigzag >>= 7;
+    }
+    buffer.push(zigzag as u8);
+}
+
+fn read_varint(data: &[u8], offset: &mut usize) -> i64 {
+    let mut result = 0u64;
+    let mut shift = 0;
+    while *offset < data.len() {
+        let byte = data[*offset];
+        *offset += 1;
+        result |= ((byte & 0x7f) as u64) << shift;
+        if byte & 0x80 == 0 {
+            break;
+        }
+        shift += 7;
+    }
+    ((result >> 1) as i64) ^ -((result & 1) as i64)
+}
+
+fn delta_encode(values: &[i64]) -> Vec<u8> {
+    let mut buffer = Vec::with_capacity(values.len() * 2);
+    let mut previous = 0i64;
+    for &value in values {
+        write_varint(&mut buffer, value.wrapping_sub(previous));
+        previous = value;
+    }
+    buffer
+}
+
+#[derive(Debug, Clone, Copy)]
+struct ChunkHeader {
+    row_count: u32,
+    min_frame: i64,
+    max_frame: i64,
+    min_timestamp: i64,
+    max_timestamp: i64,
+    columns: [(u64, u64); COLUMN_COUNT],
+}
+
+impl ChunkHeader {
+    fn serialize(&self) -> Vec<u8> {
+        let mut buffer = Vec::with_capacity(HEADER_SIZE);
+        buffer.extend(CHUNK_MAGIC);
+        buffer.extend(&self.row_count.to_le_bytes());
+        buffer.extend(&(COLUMN_COUNT as u32).to_le_bytes());
+        buffer.extend(&0u32.to_le_bytes());
+        buffer.extend(&self.min_frame.to_le_bytes());
+        buffer.extend(&self.max_frame.to_le_bytes());
+        buffer.extend(&self.min_timestamp.to_le_bytes());
+        buffer.extend(&self.max_timestamp.to_le_bytes());
+        for (offset, length) in &self.columns {
+            buffer.extend(&offset.to_le_bytes());
+            buffer.extend(&length.to_le_bytes());
+        }
+        buffer
+    }
+
+    fn deserialize(data: &[u8]) -> Result<Self, String> {
+        if data.len() < HEADER_SIZE || &data[0..8] != CHUNK_MAGIC {
+            return Err("Invalid chunk header".to_owned());
+        }
+        let u32_at = |offset: usize| u32::from_le_bytes(data[offset..offset + 4].try_into().unwrap());
+        let u64_at = |offset: usize| u64::from_le_bytes(data[offset..offset + 8].try_into().unwrap());
+        if u32_at(12) as usize != COLUMN_COUNT {
+            return Err("Unexpected column count".to_owned());
+        }
+        let mut columns = [(0u64, 0u64); COLUMN_COUNT];
+        for (i, column) in columns.iter_mut().enumerate() {
+            let base = 52 + i * 16;
+            *column = (u64_at(base), u64_at(base + 8));
+            if (column.0 + column.1) as usize > data.len() {
+                return Err(format!("Column {} is out of bounds", i));
+            }
+        }
+        Ok(ChunkHeader {
+            row_count: u32_at(8),
+            min_frame: u64_at(20) as i64,
+            max_frame: u64_at(28) as i64,
+            min_timestamp: u64_at(36) as i64,
+            max_timestamp: u64_at(44) as i64,
+            columns,
+        })
+    }
+}
+
+#[derive(Default)]
+struct ChunkBuilder {
+    timestamps: Vec<i64>,
+    frame_numbers: Vec<i64>,
+    function_ids: Vec<u32>,
+    result_codes: Vec<i32>,
+    thread_ids: Vec<i64>,
+    parameter_offsets: Vec<u32>,
+    parameters: Vec<u8>,
+}
+
+impl ChunkBuilder {
+    fn len(&self) -> usize {
+        self.timestamps.len()
+    }
+
+    fn clear(&mut self) {
+        self.timestamps.clear();
+        self.frame_numbers.clear();
+        self.function_ids.clear();
+        self.result_codes.clear();
+        self.thread_ids.clear();
+        self.parameter_offsets.clear();
+        self.parameters.clear();
+    }
+
+    fn encode(&self) -> Vec<u8> {
+        let mut parameters = Vec::with_capacity((self.parameter_offsets.len() + 1) * 4 + self.parameters.len());
+        for offset in &self.parameter_offsets {
+            parameters.extend(&offset.to_le_bytes());
+        }
+        parameters.extend(&(self.parameters.len() as u32).to_le_bytes());
+        parameters.extend(&self.parameters);
+
+        let mut histogram = HashMap::<u32, u32>::new();
+        for &id in &self.function_ids {
+            *histogram.entry(id).or_insert(0) += 1;
+        }
+        let mut histogram: Vec<(u32, u32)> = histogram.into_iter().collect();
+        histogram.sort_unstable();
+
+        let columns: [Vec<u8>; COLUMN_COUNT] = [
+            delta_encode(&self.timestamps),
+            delta_encode(&self.frame_numbers),
+            self.function_ids.iter().flat_map(|v| v.to_le_bytes()).collect(),
+            self.result_codes.iter().flat_map(|v| v.to_le_bytes()).collect(),
+            self.thread_ids.iter().flat_map(|v| v.to_le_bytes()).collect(),
+            parameters,
+            histogram
+                .iter()
+                .flat_map(|(id, count)| id.to_le_bytes().into_iter().chain(count.to_le_bytes()))
+                .collect(),
+        ];
+
+        let mut header = ChunkHeader {
+            row_count: self.len() as u32,
+            min_frame: self.frame_numbers.iter().copied().min().unwrap_or(0),
+            max_frame: self.frame_numbers.iter().copied().max().unwrap_or(0),
+            min_timestamp: self.timestamps.iter().copied().min().unwrap_or(0),
+            max_timestamp: self.timestamps.iter().copied().max().unwrap_or(0),
+            columns: [(0, 0); COLUMN_COUNT],
+        };
+        let mut offset = HEADER_SIZE as u64;
+        for (i, column) in columns.iter().enumerate() {
+            header.columns[i] = (offset, column.len() as u64);
+            offset += column.len() as u64;
+        }
+
+        let mut buffer = header.serialize();
+        for column in &columns {
+            buffer.extend(column);
+        }
+        buffer
+    }
+}
+
+/// Appends `vulkan_event` rows to a column store directory.
+/// Only used by the collector's writer thread.
+pub struct EventStoreWriter {
+    directory: PathBuf,
+    dictionary: HashMap<String, u32>,
+    dictionary_file: File,
+    chunk: ChunkBuilder,
+    next_chunk_index: u32,
+    last_seal: Instant,
+}
+
+impl EventStoreWriter {
+    pub fn create(directory: &Path) -> io::Result<Self> {
+        fs::create_dir_all(directory)?;
+        let dictionary_file = OpenOptions::new()
+            .create(true)
+            .truncate(true)
+            .write(true)
+            .open(directory.join(DICTIONARY_FILE))?;
+        Ok(EventStoreWriter {
+            directory: directory.to_path_buf(),
+            dictionary: HashMap::new(),
+            dictionary_file,
+            chunk: ChunkBuilder::default(),
+            next_chunk_index: 0,
+            last_seal: Instant::now(),
+        })
+    }
+
+    pub fn append(
+        &mut self,
+        timestamp: i64,
+        frame_number: i64,
+        function_name: &str,
+        parameters: &str,
+        result_code: i32,
+        thread_id: i64,
+    ) -> io::Result<()> {
+        let function_id = match self.dictionary.get(function_name) {
+            Some(id) => *id,
+            None => {
+                let id = self.dictionary.len() as u32;
+                self.dictionary_file.write_all(&(function_name.len() as u32).to_le_bytes())?;
+                self.dictionary_file.write_all(function_name.as_bytes())?;
+                self.dictionary.insert(function_name.to_owned(), id);
+                id
+            }
+        };
+
+        self.chunk.timestamps.push(timestamp);
+        self.chunk.frame_numbers.push(frame_number);
+        self.chunk.function_ids.push(function_id);
+        self.chunk.result_codes.push(result_code);
+        self.chunk.thread_ids.push(thread_id);
+        self.chunk.parameter_offsets.push(self.chunk.parameters.len() as u32);
+        self.chunk.parameters.extend(parameters.as_bytes());
+
+        if self.chunk.len() >= CHUNK_CAPACITY {
+            self.seal()?;
+        }
+        Ok(())
+    }
+
+    /// Seals the pending rows if the last chunk was written more than `age` ago,
+    /// so that readers see recent events without waiting for a full chunk.
+    pub fn seal_if_older_than(&mut self, age: Duration) -> io::Result<()> {
+        if self.chunk.len() > 0 && self.last_seal.elapsed() >= age {
+            self.seal()?;
+        }
+        Ok(())
+    }
+
+    pub fn seal(&mut self) -> io::Result<()> {
+        if self.chunk.len() == 0 {
+            return Ok(());
+        }
+        // Readers resolve function ids through the dictionary, it must be on disk before the chunk.
+        self.dictionary_file.flush()?;
+        self.dictionary_file.sync_data()?;
+
+        let path = chunk_path(&self.directory, self.next_chunk_index);
+        let temporary_path = path.with_extension("tmp");
+        fs::write(&temporary_path, self.chunk.encode())?;
+        fs::rename(&temporary_path, &path)?;
+
+        self.next_chunk_index += 1;
+        self.chunk.clear();
+        self.last_seal = Instant::now();
+        Ok(())
+    }
+}
+
+impl Drop for EventStoreWriter {
+    fn drop(&mut self) {
+        if let Err(e) = self.seal() {
+            eprintln!("Failed to seal event chunk: {}", e);
+        }
+    }
+}
+
+#[derive(Debug, Serialize)]
+pub struct EventRow {
+    pub timestamp: i64,
+    pub frame_number: i64,
+    pub function_name: String,
+    pub parameters: String,
+    pub result_code: i32,
+    pub thread_id: i64,
+}
+
+#[derive(Debug, Serialize)]
+pub struct FunctionCallCount {
+    pub function_name: String,
+    pub call_count: u64,
+}
+
+struct MappedChunk {
+    map: Mmap,
+    header: ChunkHeader,
+}
+
+impl MappedChunk {
+    fn column(&self, index: usize) -> &[u8] {
+        let (offset, length) = self.header.columns[index];
+        &self.map[offset as usize..(offset + length) as usize]
+    }
+
+    fn function_id(&self, row: usize) -> u32 {
+        let column = self.column(COLUMN_FUNCTION_ID);
+        u32::from_le_bytes(column[row * 4..row * 4 + 4].try_into().unwrap())
+    }
+
+    /// (function id, row count) of every function called in the chunk.
+    fn function_histogram(&self) -> impl Iterator<Item = (u32, u32)> + '_ {
+        self.column(COLUMN_FUNCTION_HISTOGRAM).chunks_exact(8).map(|pair| {
+            (
+                u32::from_le_bytes(pair[0..4].try_into().unwrap()),
+                u32::from_le_bytes(pair[4..8].try_into().unwrap()),
+            )
+        })
+    }
+}
+
+/// Read side of the column store, shared by the Tauri commands.
+pub struct EventStoreReader {
+    directory: PathBuf,
+    chunks: Vec<MappedChunk>,
+    function_names: Vec<String>,
+}
+
+impl EventStoreReader {
+    pub fn open(directory: &Path) -> Self {
+        EventStoreReader {
+            directory: directory.to_path_buf(),
+            chunks: Vec::new(),
+            function_names: Vec::new(),
+        }
+    }
+
+    /// Maps chunks sealed since the last call. Chunks are numbered sequentially
+    /// and never rewritten, so already mapped ones stay valid.
+    pub fn refresh(&mut self) -> Result<(), String> {
+        loop {
+            let path = chunk_path(&self.directory, self.chunks.len() as u32);
+            let file = match File::open(&path) {
+                Ok(file) => file,
+                Err(e) if e.kind() == io::ErrorKind::NotFound => break,
+                Err(e) => return Err(format!("Failed to open {}: {}", path.display(), e)),
+            };
+            let map = unsafe { Mmap::map(&file) }.map_err(|e| format!("Failed to map {}: {}", path.display(), e))?;
+            let header = ChunkHeader::deserialize(&map)?;
+            self.chunks.push(MappedChunk { map, header });
+        }
+        self.load_dictionary()
+    }
+
+    fn load_dictionary(&mut self) -> Result<(), String> {
+        let mut data = Vec::new();
+        match File::open(self.directory.join(DICTIONARY_FILE)) {
+            Ok(mut file) => file.read_to_end(&mut data).map_err(|e| format!("Failed to read dictionary: {}", e))?,
+            Err(e) if e.kind() == io::ErrorKind::NotFound => return Ok(()),
+            Err(e) => return Err(format!("Failed to open dictionary: {}", e)),
+        };
+
+        let mut names = Vec::new();
+        let mut offset = 0;
+        while offset + 4 <= data.len() {
+            let len = u32::from_le_bytes(data[offset..offset + 4].try_into().unwrap()) as usize;
+            offset += 4;
+            if offset + len > data.len() {
+                break;
+            }
+            names.push(String::from_utf8_lossy(&data[offset..offset + len]).into_owned());
+            offset += len;
+        }
+        self.function_names = names;
+        Ok(())
+    }
+
+    /// Calls `visit_chunk` with the chunks `frames` fully covers, whose rows are not read, and
+    /// `visit_row` with the function id of the events of `frames` in the chunks it cuts through.
+    fn for_each_function_id(
+        &self,
+        frames: &RangeInclusive<i64>,
+        mut visit_chunk: impl FnMut(&MappedChunk),
+        mut visit_row: impl FnMut(u32),
+    ) {
+        for chunk in &self.chunks {
+            let header = &chunk.header;
+            if header.max_frame < *frames.start() || header.min_frame > *frames.end() {
+                continue;
+            }
+            if frames.contains(&header.min_frame) && frames.contains(&header.max_frame) {
+                visit_chunk(chunk);
+                continue;
+            }
+            let row_count = header.row_count as usize;
+            let frame_column = chunk.column(COLUMN_FRAME_NUMBER);
+            let mut offset = 0;
+            let mut frame = 0i64;
+            for row in 0..row_count {
+                frame = frame.wrapping_add(read_varint(frame_column, &mut offset));
+                if frames.contains(&frame) {
+                    visit_row(chunk.function_id(row));
+                }
+            }
+        }
+    }
+
+    pub fn event_count(&self, frames: RangeInclusive<i64>) -> u64 {
+        let mut chunk_count = 0u64;
+        let mut row_count = 0u64;
+        self.for_each_function_id(&frames, |chunk| chunk_count += chunk.header.row_count as u64, |_| row_count += 1);
+        chunk_count + row_count
+    }
+
+    pub fn function_call_counts(&self, frames: RangeInclusive<i64>) -> Vec<FunctionCallCount> {
+        let mut counts = vec![0u64; self.function_names.len()];
+        let mut rows = vec![0u64; self.function_names.len()];
+        self.for_each_function_id(
+            &frames,
+            |chunk| {
+                for (id, count) in chunk.function_histogram() {
+                    if let Some(total) = counts.get_mut(id as usize) {
+                        *total += count as u64;
+                    }
+                }
+            },
+            |id| {
+                if let Some(count) = rows.get_mut(id as usize) {
+                    *count += 1;
+                }
+            },
+        );
+        for (count, rows) in counts.iter_mut().zip(rows) {
+            *count += rows;
+        }
+
+        let mut result: Vec<FunctionCallCount> = counts
+            .into_iter()
+            .enumerate()
+            .filter(|(_, count)| *count > 0)
+            .map(|(id, call_count)| FunctionCallCount {
+                function_name: self.function_names[id].clone(),
+                call_count,
+            })
+            .collect();
+        result.sort_by(|a, b| b.call_count.cmp(&a.call_count));
+        result
+    }
+
+    /// Returns the raw rows of `frames`, used when the UI drills into a frame.
+    pub fn events(&self, frames: RangeInclusive<i64>, limit: usize) -> Vec<EventRow> {
+        let mut events = Vec::new();
+        for chunk in &self.chunks {
+            let header = &chunk.header;
+            if header.max_frame < *frames.start() || header.min_frame > *frames.end() {
+                continue;
+            }
+            let timestamps = chunk.column(COLUMN_TIMESTAMP);
+            let frame_numbers = chunk.column(COLUMN_FRAME_NUMBER);
+            let result_codes = chunk.column(COLUMN_RESULT_CODE);
+            let thread_ids = chunk.column(COLUMN_THREAD_ID);
+            let parameters = chunk.column(COLUMN_PARAMETERS);
+            let row_count = header.row_count as usize;
+            let parameters_data = &parameters[(row_count + 1) * 4..];
+            let parameter_offset = |row: usize| u32::from_le_bytes(parameters[row * 4..row * 4 + 4].try_into().unwrap()) as usize;
+
+            let (mut timestamp_offset, mut frame_offset) = (0, 0);
+            let (mut timestamp, mut frame) = (0i64, 0i64);
+            for row in 0..row_count {
+                timestamp = timestamp.wrapping_add(read_varint(timestamps, &mut timestamp_offset));
+                frame = frame.wrapping_add(read_varint(frame_numbers, &mut frame_offset));
+                if !frames.contains(&frame) {
+                    continue;
+                }
+                let function_name = self
+                    .function_names
+                    .get(chunk.function_id(row) as usize)
+                    .cloned()
+                    .unwrap_or_default();
+                let parameters = String::from_utf8_lossy(&parameters_data[parameter_offset(row)..parameter_offset(row + 1)]).into_owned();
+                let result_code = i32::from_le_bytes(result_codes[row * 4..row * 4 + 4].try_into().unwrap());
+                let thread_id = i64::from_le_bytes(thread_ids[row * 8..row * 8 + 8].try_into().unwrap());
+                events.push(EventRow {
+                    timestamp,
+                    frame_number: frame,
+                    function_name,
+                    parameters,
+                    result_code,
+                    thread_id,
+                });
+                if events.len() >= limit {
+                    return events;
+                }
+            }
+        }
+        events
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// A fresh directory per test, tests run in parallel.
+    fn test_directory(name: &str) -> PathBuf {
+        let directory = std::env::temp_dir().join(format!("vmi_event_store_{}_{}", name, std::process::id()));
+        let _ = fs::remove_dir_all(&directory);
+        directory
+    }
+
+    fn delta_decode(data: &[u8]) -> Vec<i64> {
+        let mut values = Vec::new();
+        let mut offset = 0;
+        let mut value = 0i64;
+        while offset < data.len() {
+            value = value.wrapping_add(read_varint(data, &mut offset));
+            values.push(value);
+        }
+        values
+    }
+
+    fn append_frames(writer: &mut EventStoreWriter, frames: RangeInclusive<i64>, rows_per_frame: i64) {
+        for frame in frames {
+            for row in 0..rows_per_frame {
+                let function_name = if row % 3 == 0 { "vkQueueSubmit" } else { "vkCmdDraw" };
+                writer
+                    .append(frame * 1000 + row, frame, function_name, "{}", row as i32, 1)
+                    .unwrap();
+            }
+        }
+    }
+
+    /// Counts of `frames` taken from the raw rows, the reference for function_call_counts.
+    fn counts_from_events(reader: &EventStoreReader, frames: RangeInclusive<i64>) -> HashMap<String, u64> {
+        let mut counts = HashMap::new();
+        for event in reader.events(frames, usize::MAX) {
+            *counts.entry(event.function_name).or_insert(0u64) += 1;
+        }
+        counts
+    }
+
+    fn counts_to_map(counts: Vec<FunctionCallCount>) -> HashMap<String, u64> {
+        counts.into_iter().map(|count| (count.function_name, count.call_count)).collect()
+    }
+
+    #[test]
+    fn varint_round_trip() {
+        let values = [0, 1, -1, 63, -64, 64, -65, 1 << 35, -(1 << 35), i64::MAX, i64::MIN];
+        for &value in &values {
+            let mut buffer = Vec::new();
+            write_varint(&mut buffer, value);
+            let mut offset = 0;
+            assert_eq!(read_varint(&buffer, &mut offset), value);
+            assert_eq!(offset, buffer.len());
+        }
+
+        // Zigzag keeps small magnitudes of either sign on a single byte
+        for value in [0, 1, -1, 63, -64] {
+            let mut buffer = Vec::new();
+            write_varint(&mut buffer, value);
+            assert_eq!(buffer.len(), 1, "{}", value);
+        }
+    }
+
+    #[test]
+    fn delta_round_trip() {
+        // Deltas between the extremes wrap around
+        let values = vec![1_700_000_000_000_000, 1_700_000_000_000_013, 5, -5, i64::MIN, i64::MAX, 0, 0];
+        assert_eq!(delta_decode(&delta_encode(&values)), values);
+        assert!(delta_encode(&[]).is_empty());
+    }
+
+    #[test]
+    fn seal_renames_the_temporary_chunk() {
+        let directory = test_directory("seal");
+        let mut writer = EventStoreWriter::create(&directory).unwrap();
+        append_frames(&mut writer, 0..=1, 4);
+
+        let mut reader = EventStoreReader::open(&directory);
+        reader.refresh().unwrap();
+        assert_eq!(reader.event_count(0..=1), 0);
+
+        writer.seal().unwrap();
+        assert!(chunk_path(&directory, 0).exists());
+        assert!(!chunk_path(&directory, 0).with_extension("tmp").exists());
+
+        // A chunk that was not renamed yet is not mapped
+        fs::write(chunk_path(&directory, 1).with_extension("tmp"), b"partial").unwrap();
+        reader.refresh().unwrap();
+        assert_eq!(reader.event_count(0..=1), 8);
+
+        drop(writer);
+        fs::remove_dir_all(&directory).unwrap();
+    }
+
+    #[test]
+    fn full_chunks_are_sealed() {
+        let directory = test_directory("capacity");
+        let mut writer = EventStoreWriter::create(&directory).unwrap();
+        for row in 0..CHUNK_CAPACITY as i64 + 1 {
+            writer.append(row, row / 1024, "vkCmdDraw", "", 0, 1).unwrap();
+        }
+        assert!(chunk_path(&directory, 0).exists());
+        assert!(!chunk_path(&directory, 1).exists());
+
+        drop(writer);
+        let mut reader = EventStoreReader::open(&directory);
+        reader.refresh().unwrap();
+        assert_eq!(reader.event_count(0..=i64::MAX), CHUNK_CAPACITY as u64 + 1);
+
+        fs::remove_dir_all(&directory).unwrap();
+    }
+
+    #[test]
+    fn frame_ranges_at_chunk_boundaries() {
+        let directory = test_directory("boundaries");
+        let mut writer = EventStoreWriter::create(&directory).unwrap();
+        // Frame 4 is split between the first two chunks, frame 9 starts the third one
+        append_frames(&mut writer, 0..=4, 10);
+        writer.seal().unwrap();
+        append_frames(&mut writer, 4..=8, 10);
+        writer.seal().unwrap();
+        append_frames(&mut writer, 9..=9, 10);
+        drop(writer);
+
+        let mut reader = EventStoreReader::open(&directory);
+        reader.refresh().unwrap();
+        assert_eq!(reader.event_count(4..=4), 20);
+        assert_eq!(reader.event_count(0..=3), 40);
+        assert_eq!(reader.event_count(5..=8), 40);
+        assert_eq!(reader.event_count(8..=9), 20);
+        assert_eq!(reader.event_count(10..=20), 0);
+        assert_eq!(reader.event_count(i64::MIN..=-1), 0);
+        assert_eq!(reader.event_count(i64::MIN..=i64::MAX), 110);
+
+        let events = reader.events(4..=4, usize::MAX);
+        assert_eq!(events.len(), 20);
+        assert!(events.iter().all(|event| event.frame_number == 4));
+        assert_eq!(events[0].timestamp, 4000);
+        assert_eq!(reader.events(0..=9, 15).len(), 15);
+
+        fs::remove_dir_all(&directory).unwrap();
+    }
+
+    #[test]
+    fn zone_map_skips_chunks() {
+        let directory = test_directory("zone_map");
+        let mut writer = EventStoreWriter::create(&directory).unwrap();
+        append_frames(&mut writer, 15..=15, 10);
+        drop(writer);
+
+        // Make the zone map claim frames 0 to 9, the rows of frame 15 are only found if the chunk is scanned
+        let path = chunk_path(&directory, 0);
+        let mut data = fs::read(&path).unwrap();
+        data[20..28].copy_from_slice(&0i64.to_le_bytes());
+        data[28..36].copy_from_slice(&9i64.to_le_bytes());
+        fs::write(&path, data).unwrap();
+
+        let mut reader = EventStoreReader::open(&directory);
+        reader.refresh().unwrap();
+        assert_eq!(reader.event_count(10..=20), 0);
+        assert!(reader.function_call_counts(10..=20).is_empty());
+        assert!(reader.events(10..=20, usize::MAX).is_empty());
+
+        fs::remove_dir_all(&directory).unwrap();
+    }
+
+    #[test]
+    fn whole_chunks_are_counted_without_their_rows() {
+        let directory = test_directory("histogram");
+        let mut writer = EventStoreWriter::create(&directory).unwrap();
+        append_frames(&mut writer, 0..=9, 6);
+        drop(writer);
+
+        // Point every row at the last dictionary entry, only the rows that are read see it
+        let path = chunk_path(&directory, 0);
+        let mut data = fs::read(&path).unwrap();
+        let header = ChunkHeader::deserialize(&data).unwrap();
+        let (offset, length) = header.columns[COLUMN_FUNCTION_ID];
+        for id in data[offset as usize..(offset + length) as usize].chunks_exact_mut(4) {
+            id.copy_from_slice(&1u32.to_le_bytes());
+        }
+        fs::write(&path, data).unwrap();
+
+        let mut reader = EventStoreReader::open(&directory);
+        reader.refresh().unwrap();
+        let counts = counts_to_map(reader.function_call_counts(0..=9));
+        assert_eq!(counts.get("vkQueueSubmit"), Some(&20));
+        assert_eq!(counts.get("vkCmdDraw"), Some(&40));
+        assert_eq!(reader.event_count(0..=9), 60);
+        assert_eq!(reader.event_count(i64::MIN..=i64::MAX), 60);
+
+        // A range that cuts through the chunk reads its rows
+        let counts = counts_to_map(reader.function_call_counts(0..=8));
+        assert_eq!(counts.get("vkQueueSubmit"), None);
+        assert_eq!(counts.get("vkCmdDraw"), Some(&54));
+
+        fs::remove_dir_all(&directory).unwrap();
+    }
+
+    #[test]
+    fn function_call_counts_match_the_rows() {
+        let directory = test_directory("call_counts");
+        let mut writer = EventStoreWriter::create(&directory).unwrap();
+        append_frames(&mut writer, 0..=9, 7);
+        writer.seal().unwrap();
+        append_frames(&mut writer, 10..=19, 5);
+        drop(writer);
+
+        let mut reader = EventStoreReader::open(&directory);
+        reader.refresh().unwrap();
+        // Whole chunks take the fast path, chunks the range cuts through decode their frames
+        for frames in [0..=19, 0..=9, 10..=19, 3..=12, 9..=10, 19..=25] {
+            let counts = reader.function_call_counts(frames.clone());
+            assert!(counts.windows(2).all(|pair| pair[0].call_count >= pair[1].call_count));
+            assert_eq!(counts_to_map(counts), counts_from_events(&reader, frames.clone()), "{:?}", frames);
+        }
+        assert_eq!(counts_to_map(reader.function_call_counts(0..=9)).get("vkQueueSubmit"), Some(&30));
+
+        fs::remove_dir_all(&directory).unwrap();
+    }
+}
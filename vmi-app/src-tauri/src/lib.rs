@@ -2,11 +2,17 @@ use std::collections::HashMap;
 use std::{fs, io};
 use std::path::{Path, PathBuf};
 use std::process;
+use std::sync::{Arc, Mutex};
 use r2d2::Pool;
 use r2d2_sqlite::SqliteConnectionManager;
 use rusqlite::params;
-mod bindings;
-pub fn run(pool: &Pool<SqliteConnectionManager>) {
+use control::ControlChannel;
+use event_store::EventStoreReader;
+pub mod bindings;
+pub mod collector;
+pub mod control;
+pub mod event_store;
+pub fn run(pool: &Pool<SqliteConnectionManager>, event_store_path: &Path, control: Arc<ControlChannel>) {
     tauri::Builder::default()
         .plugin(tauri_plugin_dialog::init())
         .setup(|app| {
@@ -20,16 +26,34 @@ pub fn run(pool: &Pool<SqliteConnectionManager>) {
             Ok(())
         })
         .manage(pool.clone())
+        .manage(Mutex::new(EventStoreReader::open(event_store_path)))
+        .manage(control)
         .invoke_handler(tauri::generate_handler![
             launch_application,
             get_frame_data,
+            get_function_call_counts,
+            get_vulkan_events,
+            get_frame_submissions,
+            get_cpu_stalls,
+            get_frame_timings,
+            get_object_leaks,
+            get_memory_advice,
+            set_capture_categories,
+            set_sampling_rate,
+            request_snapshot,
         ])
         .run(tauri::generate_context!())
         .expect("error while running tauri application");
 }
 
 #[tauri::command]
-fn launch_application(file_path: String, working_directory: String, command_args: String) -> Result<(), String> {
+fn launch_application(file_path: String, working_directory: String, command_args: String, active_categories: Option<Vec<String>>) -> Result<(), String> {
+    // Every category stays routed (VMI_CAPTURE unset) so that set_capture_categories can raise
+    // the detail level later, only the active ones are captured from the start
+    let active_categories = active_categories
+        .unwrap_or_else(|| control::DEFAULT_ACTIVE_CATEGORIES.iter().map(|category| category.to_string()).collect());
+    control::parse_capture_categories(&active_categories)?;
+
     let file_path = PathBuf::from(file_path);
     let working_directory = PathBuf::from(working_directory);
     let command_args = command_args
@@ -52,6 +76,7 @@ fn launch_application(file_path: String, working_directory: String, command_args
     env.insert("VK_INSTANCE_LAYERS".into(), "VK_LAYER_AV_vmi".into());
     env.insert("VK_LOADER_LAYERS_ENABLE".into(), "VK_LAYER_AV_vmi".into());
     env.insert("ENABLE_VMI_LAYER".into(), "1".into());
+    env.insert("VMI_CAPTURE_ACTIVE".into(), active_categories.join(","));
     env.insert("VK_LOADER_DEBUG".into(), "all".into());
 
     match spawn_detached_process(file_path.as_path(), &command_args, &working_directory, &env) {
@@ -84,6 +109,223 @@ fn get_frame_data(pool: tauri::State<r2d2::Pool<r2d2_sqlite::SqliteConnectionMan
     Ok(frames)
 }
 
+#[tauri::command]
+fn get_function_call_counts(event_store: tauri::State<Mutex<EventStoreReader>>, first_frame: i64, last_frame: i64) -> Result<Vec<event_store::FunctionCallCount>, String> {
+    let mut reader = event_store.lock().map_err(|e| format!("Failed to lock the event store: {}", e))?;
+    reader.refresh()?;
+    Ok(reader.function_call_counts(first_frame..=last_frame))
+}
+
+#[tauri::command]
+fn get_vulkan_events(event_store: tauri::State<Mutex<EventStoreReader>>, first_frame: i64, last_frame: i64, size: u32) -> Result<Vec<event_store::EventRow>, String> {
+    let mut reader = event_store.lock().map_err(|e| format!("Failed to lock the event store: {}", e))?;
+    reader.refresh()?;
+    Ok(reader.events(first_frame..=last_frame, size as usize))
+}
+
+#[derive(Debug, serde::Serialize)]
+struct FrameSubmissions {
+    frame_index: i32,
+    submit_count: i64,
+    batch_count: i64,
+    command_buffer_count: i64,
+    wait_semaphore_count: i64,
+    signal_semaphore_count: i64,
+    submit_cpu_ns: i64,
+    stall_count: i64,
+    stall_cpu_ns: i64,
+}
+
+#[tauri::command]
+fn get_frame_submissions(pool: tauri::State<r2d2::Pool<r2d2_sqlite::SqliteConnectionManager>>, first_frame: i32, last_frame: i32) -> Result<Vec<FrameSubmissions>, String> {
+    let conn = pool.get().map_err(|e| format!("Failed to get connection from pool: {}", e))?;
+    let mut stmt = conn.prepare(
+        "SELECT frame_index,
+                SUM(function_name LIKE 'vkQueueSubmit%'),
+                SUM(CASE WHEN function_name LIKE 'vkQueueSubmit%' THEN batch_count ELSE 0 END),
+                SUM(CASE WHEN function_name LIKE 'vkQueueSubmit%' THEN command_buffer_count ELSE 0 END),
+                SUM(CASE WHEN function_name LIKE 'vkQueueSubmit%' THEN wait_semaphore_count ELSE 0 END),
+                SUM(CASE WHEN function_name LIKE 'vkQueueSubmit%' THEN signal_semaphore_count ELSE 0 END),
+                SUM(CASE WHEN function_name LIKE 'vkQueueSubmit%' THEN cpu_duration_ns ELSE 0 END),
+                SUM(is_stall),
+                SUM(CASE WHEN is_stall THEN cpu_duration_ns ELSE 0 END)
+         FROM queue_activity
+         WHERE frame_index BETWEEN ?1 AND ?2
+         GROUP BY frame_index
+         ORDER BY frame_index"
+    ).map_err(|e| format!("Failed to prepare statement: {}", e))?;
+    let rows = stmt.query_map(params![first_frame, last_frame], |row| {
+        Ok(FrameSubmissions {
+            frame_index: row.get(0)?,
+            submit_count: row.get(1)?,
+            batch_count: row.get(2)?,
+            command_buffer_count: row.get(3)?,
+            wait_semaphore_count: row.get(4)?,
+            signal_semaphore_count: row.get(5)?,
+            submit_cpu_ns: row.get(6)?,
+            stall_count: row.get(7)?,
+            stall_cpu_ns: row.get(8)?,
+        })
+    }).map_err(|e| format!("Failed to query map: {}", e))?;
+
+    let mut frames = Vec::new();
+    for frame in rows {
+        frames.push(frame.map_err(|e| format!("Error reading row: {}", e))?);
+    }
+    Ok(frames)
+}
+
+#[tauri::command]
+fn get_cpu_stalls(pool: tauri::State<r2d2::Pool<r2d2_sqlite::SqliteConnectionManager>>, first_frame: i32, last_frame: i32, size: u32) -> Result<Vec<bindings::QueueActivity>, String> {
+    let conn = pool.get().map_err(|e| format!("Failed to get connection from pool: {}", e))?;
+    let mut stmt = conn.prepare(
+        "SELECT id, frame_index, function_name, queue, started_at, cpu_duration_ns, batch_count, command_buffer_count, wait_semaphore_count, signal_semaphore_count, is_stall, result_code
+         FROM queue_activity
+         WHERE is_stall != 0 AND frame_index BETWEEN ?1 AND ?2
+         ORDER BY cpu_duration_ns DESC
+         LIMIT ?3"
+    ).map_err(|e| format!("Failed to prepare statement: {}", e))?;
+    let rows = stmt.query_map(params![first_frame, last_frame, size], |row| {
+        Ok(bindings::QueueActivity {
+            id: row.get(0)?,
+            frame_index: row.get(1)?,
+            function_name: row.get(2)?,
+            queue: row.get(3)?,
+            started_at: row.get(4)?,
+            cpu_duration_ns: row.get(5)?,
+            batch_count: row.get(6)?,
+            command_buffer_count: row.get(7)?,
+            wait_semaphore_count: row.get(8)?,
+            signal_semaphore_count: row.get(9)?,
+            is_stall: row.get(10)?,
+            result_code: row.get(11)?,
+        })
+    }).map_err(|e| format!("Failed to query map: {}", e))?;
+
+    let mut stalls = Vec::new();
+    for stall in rows {
+        stalls.push(stall.map_err(|e| format!("Error reading row: {}", e))?);
+    }
+    Ok(stalls)
+}
+
+#[tauri::command]
+fn get_frame_timings(pool: tauri::State<r2d2::Pool<r2d2_sqlite::SqliteConnectionManager>>, swapchain: Option<i64>, size: u32) -> Result<Vec<bindings::FrameTiming>, String> {
+    let conn = pool.get().map_err(|e| format!("Failed to get connection from pool: {}", e))?;
+    let mut stmt = conn.prepare(
+        "SELECT id, swapchain, first_frame_index, last_frame_index, frame_count, sent_at, min_us, p50_us, p95_us, p99_us, max_us
+         FROM frame_timing
+         WHERE ?1 IS NULL OR swapchain = ?1
+         ORDER BY sent_at
+         LIMIT ?2"
+    ).map_err(|e| format!("Failed to prepare statement: {}", e))?;
+    let rows = stmt.query_map(params![swapchain, size], |row| {
+        Ok(bindings::FrameTiming {
+            id: row.get(0)?,
+            swapchain: row.get(1)?,
+            first_frame_index: row.get(2)?,
+            last_frame_index: row.get(3)?,
+            frame_count: row.get(4)?,
+            sent_at: row.get(5)?,
+            min_us: row.get(6)?,
+            p50_us: row.get(7)?,
+            p95_us: row.get(8)?,
+            p99_us: row.get(9)?,
+            max_us: row.get(10)?,
+        })
+    }).map_err(|e| format!("Failed to query map: {}", e))?;
+
+    let mut timings = Vec::new();
+    for timing in rows {
+        timings.push(timing.map_err(|e| format!("Error reading row: {}", e))?);
+    }
+    Ok(timings)
+}
+
+#[tauri::command]
+fn get_object_leaks(pool: tauri::State<r2d2::Pool<r2d2_sqlite::SqliteConnectionManager>>) -> Result<Vec<bindings::ObjectLeak>, String> {
+    let conn = pool.get().map_err(|e| format!("Failed to get connection from pool: {}", e))?;
+    let mut stmt = conn.prepare(
+        "SELECT id, device, object_type, leaked_count, leaked_bytes, oldest_frame_index, frame_index
+         FROM object_leak
+         ORDER BY device, leaked_bytes DESC"
+    ).map_err(|e| format!("Failed to prepare statement: {}", e))?;
+    let rows = stmt.query_map([], |row| {
+        Ok(bindings::ObjectLeak {
+            id: row.get(0)?,
+            device: row.get(1)?,
+            object_type: row.get(2)?,
+            leaked_count: row.get(3)?,
+            leaked_bytes: row.get(4)?,
+            oldest_frame_index: row.get(5)?,
+            frame_index: row.get(6)?,
+        })
+    }).map_err(|e| format!("Failed to query map: {}", e))?;
+
+    let mut leaks = Vec::new();
+    for leak in rows {
+        leaks.push(leak.map_err(|e| format!("Error reading row: {}", e))?);
+    }
+    Ok(leaks)
+}
+
+#[tauri::command]
+fn get_memory_advice(pool: tauri::State<r2d2::Pool<r2d2_sqlite::SqliteConnectionManager>>, device: Option<i64>, first_frame: i32, last_frame: i32) -> Result<Vec<bindings::MemoryAdvice>, String> {
+    let conn = pool.get().map_err(|e| format!("Failed to get connection from pool: {}", e))?;
+    let mut stmt = conn.prepare(
+        "SELECT id, frame_index, device, buffer_count, buffer_requested_bytes, buffer_size_padding_bytes, buffer_alignment_padding_bytes, image_count, image_bytes, image_alignment_padding_bytes, dedicated_preferred_count, dedicated_ignored_count, dedicated_ignored_bytes, allocation_count, allocated_bytes, unused_allocated_bytes, small_allocation_count, small_allocation_bytes, allocation_count_limit, peak_allocation_count, pressure_allocation_count
+         FROM memory_advice
+         WHERE (?1 IS NULL OR device = ?1) AND frame_index BETWEEN ?2 AND ?3
+         ORDER BY frame_index, device"
+    ).map_err(|e| format!("Failed to prepare statement: {}", e))?;
+    let rows = stmt.query_map(params![device, first_frame, last_frame], |row| {
+        Ok(bindings::MemoryAdvice {
+            id: row.get(0)?,
+            frame_index: row.get(1)?,
+            device: row.get(2)?,
+            buffer_count: row.get(3)?,
+            buffer_requested_bytes: row.get(4)?,
+            buffer_size_padding_bytes: row.get(5)?,
+            buffer_alignment_padding_bytes: row.get(6)?,
+            image_count: row.get(7)?,
+            image_bytes: row.get(8)?,
+            image_alignment_padding_bytes: row.get(9)?,
+            dedicated_preferred_count: row.get(10)?,
+            dedicated_ignored_count: row.get(11)?,
+            dedicated_ignored_bytes: row.get(12)?,
+            allocation_count: row.get(13)?,
+            allocated_bytes: row.get(14)?,
+            unused_allocated_bytes: row.get(15)?,
+            small_allocation_count: row.get(16)?,
+            small_allocation_bytes: row.get(17)?,
+            allocation_count_limit: row.get(18)?,
+            peak_allocation_count: row.get(19)?,
+            pressure_allocation_count: row.get(20)?,
+        })
+    }).map_err(|e| format!("Failed to query map: {}", e))?;
+
+    let mut advice = Vec::new();
+    for row in rows {
+        advice.push(row.map_err(|e| format!("Error reading row: {}", e))?);
+    }
+    Ok(advice)
+}
+
+#[tauri::command]
+fn set_capture_categories(channel: tauri::State<Arc<ControlChannel>>, categories: Vec<String>, enabled: bool) -> Result<usize, String> {
+    channel.set_capture_categories(control::parse_capture_categories(&categories)?, enabled)
+}
+
+#[tauri::command]
+fn set_sampling_rate(channel: tauri::State<Arc<ControlChannel>>, sampling_rate: u32) -> Result<usize, String> {
+    channel.set_sampling_rate(sampling_rate)
+}
+
+#[tauri::command]
+fn request_snapshot(channel: tauri::State<Arc<ControlChannel>>, categories: Vec<String>) -> Result<usize, String> {
+    channel.request_snapshot(control::parse_snapshot_categories(&categories)?)
+}
+
 #[cfg(windows)]
 fn spawn_detached_process(
     program_path: &Path,
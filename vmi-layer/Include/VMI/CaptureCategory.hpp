@@ -0,0 +1,50 @@
+//
+// Created by arthur on 18/10/2026.
+//
+
+#ifndef VMI_CAPTURECATEGORY_HPP
+#define VMI_CAPTURECATEGORY_HPP
+
+#include <string_view>
+
+#include "VMI/Defines.hpp"
+
+enum class CaptureCategory : cct::UInt32
+{
+	Core = 1 << 0,			// Layer bookkeeping (instance, device, present), always captured
+	ApiTrace = 1 << 1,		// One vulkan_event per intercepted command
+	Memory = 1 << 2,		// Device memory, buffers and images
+	CommandBuffer = 1 << 3,	// Command buffer recording
+	HostMemory = 1 << 4,	// Driver host allocations made through the layer callbacks
+	Submission = 1 << 5,	// Queue submissions and the calls blocking on the GPU
+	Lifetime = 1 << 6,		// Device objects alive, reported as leaks when their device is destroyed
+};
+
+using CaptureCategoryFlags = cct::UInt32;
+
+constexpr CaptureCategoryFlags AllCaptureCategories = ~CaptureCategoryFlags(0);
+
+constexpr bool HasCaptureCategory(CaptureCategoryFlags flags, CaptureCategory category)
+{
+	return (flags & static_cast<CaptureCategoryFlags>(category)) != 0;
+}
+
+/**
+ * @brief Parses a comma separated list of categories, e.g. "memory,api_trace". "all" enables everything.
+ * Core is always part of the result.
+ */
+CaptureCategoryFlags ParseCaptureCategories(std::string_view categories);
+
+/**
+ * @brief Categories requested at launch through the VMI_CAPTURE environment variable, all of them if unset.
+ * Commands that only belong to other categories are not routed through the layer.
+ */
+CaptureCategoryFlags GetStartupCaptureCategories();
+
+/**
+ * @brief Categories active when the layer starts, from VMI_CAPTURE_ACTIVE, GetStartupCaptureCategories() if unset.
+ * The control channel can enable the others at runtime, as long as they were routed at startup.
+ */
+CaptureCategoryFlags GetInitialCaptureCategories();
+
+#endif //VMI_CAPTURECATEGORY_HPP
@@ -0,0 +1,30 @@
+//
+// Created by arthur on 18/10/2026.
+//
+
+#ifndef VMI_CONTROLMESSAGE_HPP
+#define VMI_CONTROLMESSAGE_HPP
+
+#include "VMI/Defines.hpp"
+
+/**
+ * @brief Requests sent by the collector on the capture socket, mirrored in vmi-app/src-tauri/src/control.rs.
+ * A message is framed like the packets, a big endian u32 length, then opcode (u32), argument (u32) and value (i64).
+ */
+enum class ControlOpcode : cct::UInt32
+{
+	SetCaptureCategories = 1,	// argument: CaptureCategoryFlags, value: 0 to disable, enabled otherwise
+	SetSamplingRate = 2,		// value: one vulkan_event is emitted every value calls
+	RequestSnapshot = 3,		// argument: CaptureCategoryFlags to publish in full right away, host_memory and memory
+};
+
+struct ControlMessage
+{
+	ControlOpcode opcode;
+	cct::UInt32 argument;
+	cct::Int64 value;
+};
+
+constexpr cct::UInt32 ControlMessageSize = 16;
+
+#endif //VMI_CONTROLMESSAGE_HPP
@@ -0,0 +1,50 @@
+//
+// Created by arthur on 18/10/2026.
+//
+
+#ifndef VMI_FRAMETIMEHISTOGRAM_HPP
+#define VMI_FRAMETIMEHISTOGRAM_HPP
+
+#include <array>
+
+#include "VMI/Defines.hpp"
+
+/**
+ * @brief Log-linear histogram of durations in microseconds, in the spirit of HdrHistogram.
+ *
+ * Values below 128 have their own bucket, above that every power of two is split in 64 linear
+ * sub-buckets, so a percentile is off by at most 1/64 (~1.6%) of its value whatever the range.
+ * Recording is a bit_width and an increment, with a fixed 8 KiB footprint.
+ */
+class FrameTimeHistogram
+{
+public:
+	static constexpr cct::UInt32 SubBucketBits = 6;
+	static constexpr cct::UInt32 SubBucketCount = 1u << SubBucketBits;
+	static constexpr cct::UInt32 MaxValueBits = 37; // ~38 hours
+	static constexpr cct::UInt32 BucketCount = (MaxValueBits - SubBucketBits + 1) * SubBucketCount;
+
+	void Record(cct::UInt64 value);
+	void Reset();
+
+	cct::UInt64 GetCount() const;
+	cct::UInt64 GetMin() const;
+	cct::UInt64 GetMax() const;
+	/**
+	 * @brief Value under which percentile (0 to 100) of the recorded values fall, 0 when empty.
+	 */
+	cct::UInt64 GetPercentile(double percentile) const;
+
+	static cct::UInt32 GetBucketIndex(cct::UInt64 value);
+	static cct::UInt64 GetBucketValue(cct::UInt32 index);
+
+private:
+	std::array<cct::UInt32, BucketCount> _counts = {};
+	cct::UInt64 _count = 0;
+	cct::UInt64 _min = 0;
+	cct::UInt64 _max = 0;
+};
+
+#include "VMI/FrameTimeHistogram.inl"
+
+#endif //VMI_FRAMETIMEHISTOGRAM_HPP
@@ -0,0 +1,83 @@
+//
+// Created by arthur on 18/10/2026.
+//
+
+#ifndef VMI_FRAMETIMEHISTOGRAM_INL
+#define VMI_FRAMETIMEHISTOGRAM_INL
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#include "VMI/FrameTimeHistogram.hpp"
+
+inline cct::UInt32 FrameTimeHistogram::GetBucketIndex(cct::UInt64 value)
+{
+	constexpr cct::UInt64 maxValue = (1ull << MaxValueBits) - 1;
+	value = std::min(value, maxValue);
+	if (value < 2 * SubBucketCount)
+		return static_cast<cct::UInt32>(value);
+	// Keep the SubBucketBits + 1 most significant bits, the top one is implied by the shift
+	auto shift = static_cast<cct::UInt32>(std::bit_width(value)) - (SubBucketBits + 1);
+	return (shift + 1) * SubBucketCount + static_cast<cct::UInt32>(value >> shift) - SubBucketCount;
+}
+
+inline cct::UInt64 FrameTimeHistogram::GetBucketValue(cct::UInt32 index)
+{
+	if (index < 2 * SubBucketCount)
+		return index;
+	cct::UInt32 shift = index / SubBucketCount - 1;
+	cct::UInt64 lowest = static_cast<cct::UInt64>(index % SubBucketCount + SubBucketCount) << shift;
+	// Middle of the bucket, halves the worst case error
+	return lowest + ((1ull << shift) >> 1);
+}
+
+inline void FrameTimeHistogram::Record(cct::UInt64 value)
+{
+	++_counts[GetBucketIndex(value)];
+	_min = _count == 0 ? value : std::min(_min, value);
+	_max = std::max(_max, value);
+	++_count;
+}
+
+inline void FrameTimeHistogram::Reset()
+{
+	_counts.fill(0);
+	_count = 0;
+	_min = 0;
+	_max = 0;
+}
+
+inline cct::UInt64 FrameTimeHistogram::GetCount() const
+{
+	return _count;
+}
+
+inline cct::UInt64 FrameTimeHistogram::GetMin() const
+{
+	return _min;
+}
+
+inline cct::UInt64 FrameTimeHistogram::GetMax() const
+{
+	return _max;
+}
+
+inline cct::UInt64 FrameTimeHistogram::GetPercentile(double percentile) const
+{
+	if (_count == 0)
+		return 0;
+	auto rank = static_cast<cct::UInt64>(std::ceil(static_cast<double>(_count) * std::clamp(percentile, 0.0, 100.0) / 100.0));
+	rank = std::max<cct::UInt64>(rank, 1);
+
+	cct::UInt64 seen = 0;
+	for (cct::UInt32 i = 0; i < BucketCount; ++i)
+	{
+		seen += _counts[i];
+		if (seen >= rank)
+			return std::clamp(GetBucketValue(i), _min, _max);
+	}
+	return _max;
+}
+
+#endif //VMI_FRAMETIMEHISTOGRAM_INL
@@ -0,0 +1,60 @@
+//
+// Created by arthur on 18/10/2026.
+//
+
+#ifndef VMI_FRAMETIMELINE_HPP
+#define VMI_FRAMETIMELINE_HPP
+
+#include <atomic>
+#include <vulkan/vulkan.h>
+
+#include "VMI/Defines.hpp"
+#include "VMI/FrameTimeHistogram.hpp"
+
+class FrameTiming;
+
+/**
+ * @brief Frame epoch and present-to-present times of one swapchain.
+ *
+ * Presents to a swapchain are externally synchronized (vkQueuePresentKHR), so only the epoch,
+ * read by any thread, needs to be atomic. The histogram covers the current window and is
+ * reset every time its percentiles are taken.
+ */
+class FrameTimeline
+{
+public:
+	/**
+	 * @param device Dispatch key of the device owning swapchain
+	 * @param creationOrder Tells which of the timelines alive was presented first
+	 */
+	FrameTimeline(void* device, VkSwapchainKHR swapchain, cct::UInt64 creationOrder);
+
+	/**
+	 * @brief Advances the epoch and records the time since the previous present.
+	 * @param timestamp Steady clock, in nanoseconds
+	 * @param period Length of a window, in nanoseconds
+	 * @return true when the window is over and TakeWindow should be called
+	 */
+	bool RecordPresent(cct::Int64 timestamp, cct::Int64 period);
+	FrameTiming TakeWindow();
+	/**
+	 * @brief Whether the current window measured a frame, to flush it when the swapchain goes away.
+	 */
+	bool HasPendingWindow() const;
+
+	cct::Int32 GetEpoch() const;
+	void* GetDevice() const;
+	cct::UInt64 GetCreationOrder() const;
+
+private:
+	void* _device;
+	VkSwapchainKHR _swapchain;
+	cct::UInt64 _creationOrder;
+	std::atomic<cct::Int32> _epoch;
+	cct::Int64 _lastPresent;
+	cct::Int64 _windowStart;
+	cct::Int32 _windowFirstEpoch;
+	FrameTimeHistogram _histogram;
+};
+
+#endif //VMI_FRAMETIMELINE_HPP
@@ -0,0 +1,74 @@
+//
+// Created by arthur on 18/10/2026.
+//
+
+#ifndef VMI_HANDLETABLE_HPP
+#define VMI_HANDLETABLE_HPP
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "VMI/Defines.hpp"
+
+/**
+ * @brief Map from Vulkan handle to T with O(1) insert, find and erase.
+ *
+ * Values live in a dense slab, erasing moves the last slot into the hole so that the slab stays
+ * compact and iterating it never visits dead entries. The slab is indexed by an open addressing
+ * table (linear probing, backward shift deletion, no tombstones) kept under half full.
+ * Not thread safe, the owner synchronizes.
+ */
+template<typename T>
+class HandleTable
+{
+public:
+	/**
+	 * @return false when handle was already present, its value is replaced
+	 */
+	bool Insert(cct::UInt64 handle, const T& value);
+	bool Erase(cct::UInt64 handle);
+	T* Find(cct::UInt64 handle);
+	const T* Find(cct::UInt64 handle) const;
+	void Clear();
+
+	std::size_t GetSize() const;
+	/**
+	 * @brief Calls function(handle, value) for every entry, in slab order.
+	 */
+	template<typename Function>
+	void ForEach(Function&& function) const;
+
+private:
+	static constexpr cct::UInt32 EmptyIndex = ~0u;
+	static constexpr std::size_t MinIndexCapacity = 64;
+
+	struct Slot
+	{
+		cct::UInt64 handle;
+		T value;
+	};
+
+	std::size_t GetHome(cct::UInt64 handle) const;
+	// Position in _index holding handle, or the empty position where it would go
+	std::size_t Probe(cct::UInt64 handle) const;
+	void RemoveIndexAt(std::size_t position);
+	void Rehash(std::size_t capacity);
+
+	std::vector<Slot> _slots;
+	std::vector<cct::UInt32> _index;
+};
+
+template<typename DispatchableOrNot>
+cct::UInt64 ToHandleKey(DispatchableOrNot handle)
+{
+	// Non dispatchable handles are 64 bits integers on 32 bits platforms
+	if constexpr (std::is_pointer_v<DispatchableOrNot>)
+		return static_cast<cct::UInt64>(reinterpret_cast<std::uintptr_t>(handle));
+	else
+		return static_cast<cct::UInt64>(handle);
+}
+
+#include "VMI/HandleTable.inl"
+
+#endif //VMI_HANDLETABLE_HPP
@@ -0,0 +1,136 @@
+//
+// Created by arthur on 18/10/2026.
+//
+
+#ifndef VMI_HANDLETABLE_INL
+#define VMI_HANDLETABLE_INL
+
+#include <algorithm>
+#include <bit>
+
+#include "VMI/HandleTable.hpp"
+
+template<typename T>
+bool HandleTable<T>::Insert(cct::UInt64 handle, const T& value)
+{
+	if ((_slots.size() + 1) * 2 > _index.size())
+		Rehash(std::max(MinIndexCapacity, _index.size() * 2));
+
+	std::size_t position = Probe(handle);
+	if (_index[position] != EmptyIndex)
+	{
+		_slots[_index[position]].value = value;
+		return false;
+	}
+	_index[position] = static_cast<cct::UInt32>(_slots.size());
+	_slots.push_back(Slot{ handle, value });
+	return true;
+}
+
+template<typename T>
+bool HandleTable<T>::Erase(cct::UInt64 handle)
+{
+	if (_slots.empty())
+		return false;
+	std::size_t position = Probe(handle);
+	cct::UInt32 slot = _index[position];
+	if (slot == EmptyIndex)
+		return false;
+	RemoveIndexAt(position);
+
+	// Fill the hole with the last slot and point its index entry to the new place
+	auto last = static_cast<cct::UInt32>(_slots.size() - 1);
+	if (slot != last)
+	{
+		_index[Probe(_slots[last].handle)] = slot;
+		_slots[slot] = std::move(_slots[last]);
+	}
+	_slots.pop_back();
+	return true;
+}
+
+template<typename T>
+T* HandleTable<T>::Find(cct::UInt64 handle)
+{
+	return const_cast<T*>(static_cast<const HandleTable&>(*this).Find(handle));
+}
+
+template<typename T>
+const T* HandleTable<T>::Find(cct::UInt64 handle) const
+{
+	if (_slots.empty())
+		return nullptr;
+	cct::UInt32 slot = _index[Probe(handle)];
+	return slot == EmptyIndex ? nullptr : &_slots[slot].value;
+}
+
+template<typename T>
+void HandleTable<T>::Clear()
+{
+	_slots.clear();
+	_index.clear();
+}
+
+template<typename T>
+std::size_t HandleTable<T>::GetSize() const
+{
+	return _slots.size();
+}
+
+template<typename T>
+template<typename Function>
+void HandleTable<T>::ForEach(Function&& function) const
+{
+	for (const Slot& slot : _slots)
+		function(slot.handle, slot.value);
+}
+
+template<typename T>
+std::size_t HandleTable<T>::GetHome(cct::UInt64 handle) const
+{
+	// Fibonacci hashing, handles are often pointers or small counters and share their low bits
+	auto shift = static_cast<cct::UInt32>(64 - std::countr_zero(_index.size()));
+	return static_cast<std::size_t>((handle * 0x9E3779B97F4A7C15ull) >> shift);
+}
+
+template<typename T>
+std::size_t HandleTable<T>::Probe(cct::UInt64 handle) const
+{
+	std::size_t mask = _index.size() - 1;
+	std::size_t position = GetHome(handle);
+	while (_index[position] != EmptyIndex && _slots[_index[position]].handle != handle)
+		position = (position + 1) & mask;
+	return position;
+}
+
+template<typename T>
+void HandleTable<T>::RemoveIndexAt(std::size_t position)
+{
+	std::size_t mask = _index.size() - 1;
+	std::size_t hole = position;
+	std::size_t next = position;
+	while (true)
+	{
+		next = (next + 1) & mask;
+		if (_index[next] == EmptyIndex)
+			break;
+		// Move the entry back into the hole unless its home lies cyclically in (hole, next]
+		std::size_t home = GetHome(_slots[_index[next]].handle);
+		bool staysInPlace = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+		if (staysInPlace)
+			continue;
+		_index[hole] = _index[next];
+		hole = next;
+	}
+	_index[hole] = EmptyIndex;
+}
+
+template<typename T>
+void HandleTable<T>::Rehash(std::size_t capacity)
+{
+	_index.assign(std::bit_ceil(capacity), EmptyIndex);
+	for (std::size_t i = 0; i < _slots.size(); ++i)
+		_index[Probe(_slots[i].handle)] = static_cast<cct::UInt32>(i);
+}
+
+#endif //VMI_HANDLETABLE_INL
@@ -0,0 +1,86 @@
+//
+// Created by arthur on 18/10/2026.
+//
+
+#ifndef VMI_HOSTMEMORYTRACKER_HPP
+#define VMI_HOSTMEMORYTRACKER_HPP
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "VMI/Defines.hpp"
+
+class HostMemoryUsage;
+
+/**
+ * @brief Accounts the host allocations made by the driver through the layer allocation callbacks.
+ *
+ * Every allocation is attributed to its VkSystemAllocationScope, to the Vulkan command whose
+ * callbacks were used and to a power-of-two size class. Internal allocation notifications are
+ * accounted by VkInternalAllocationType and scope, and by command. Counters are thread local, they are only
+ * summed when the usage is published, once per frame.
+ */
+class HostMemoryTracker
+{
+public:
+	static constexpr cct::UInt32 MaxCommands = 256;
+	static constexpr cct::UInt32 ScopeCount = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+	static constexpr cct::UInt32 InternalTypeCount = VK_INTERNAL_ALLOCATION_TYPE_EXECUTABLE + 1;
+	static constexpr cct::UInt32 SizeClassCount = 32;
+	static constexpr cct::UInt32 UnknownCommand = 0;
+
+	/**
+	 * @brief Returns the index used to attribute allocations to command, registering it on first use.
+	 * Commands past MaxCommands are attributed to UnknownCommand.
+	 */
+	static cct::UInt32 RegisterCommand(std::string_view command);
+
+	static void RecordAllocation(cct::UInt32 commandIndex, VkSystemAllocationScope scope, std::size_t size);
+	static void RecordFree(cct::UInt32 commandIndex, VkSystemAllocationScope scope, std::size_t size);
+	static void RecordInternalAllocation(cct::UInt32 commandIndex, VkInternalAllocationType type, VkSystemAllocationScope scope, std::size_t size);
+	static void RecordInternalFree(cct::UInt32 commandIndex, VkInternalAllocationType type, VkSystemAllocationScope scope, std::size_t size);
+
+	/**
+	 * @brief Sums the counters of every thread and returns the rows that changed since the previous call.
+	 */
+	static std::vector<HostMemoryUsage> CollectChanges(cct::Int32 frameIndex);
+
+	/**
+	 * @brief Same as CollectChanges, but returns every row that ever saw an allocation.
+	 */
+	static std::vector<HostMemoryUsage> CollectSnapshot(cct::Int32 frameIndex);
+
+	static cct::UInt32 GetSizeClass(std::size_t size);
+
+	struct Counter
+	{
+		std::atomic<cct::Int64> allocationCount = 0;
+		std::atomic<cct::Int64> allocatedBytes = 0;
+		std::atomic<cct::Int64> freeCount = 0;
+		std::atomic<cct::Int64> freedBytes = 0;
+	};
+
+	struct ThreadCounters
+	{
+		std::array<Counter, ScopeCount> scopes;
+		std::array<Counter, MaxCommands> commands;
+		std::array<std::array<Counter, ScopeCount>, InternalTypeCount> internal;
+		std::array<Counter, MaxCommands> internalCommands;
+		std::array<Counter, SizeClassCount> sizeClasses;
+	};
+
+private:
+	static std::vector<HostMemoryUsage> Collect(cct::Int32 frameIndex, bool includeUnchanged);
+	static ThreadCounters& GetThreadCounters();
+	static void RegisterThread(ThreadCounters* counters);
+	static void UnregisterThread(ThreadCounters* counters);
+
+	friend class ThreadCountersRegistration;
+};
+
+#include "VMI/HostMemoryTracker.inl"
+
+#endif //VMI_HOSTMEMORYTRACKER_HPP
@@ -0,0 +1,75 @@
+//
+// Created by arthur on 18/10/2026.
+//
+
+#ifndef VMI_HOSTMEMORYTRACKER_INL
+#define VMI_HOSTMEMORYTRACKER_INL
+
+#include <bit>
+
+#include "VMI/HostMemoryTracker.hpp"
+
+namespace vmi::detail
+{
+	// Thread counters only have one writer, a relaxed load/store pair avoids the locked add.
+	inline void AddRelaxed(std::atomic<cct::Int64>& counter, cct::Int64 value)
+	{
+		counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+	}
+
+	inline void RecordAllocation(HostMemoryTracker::Counter& counter, std::size_t size)
+	{
+		AddRelaxed(counter.allocationCount, 1);
+		AddRelaxed(counter.allocatedBytes, static_cast<cct::Int64>(size));
+	}
+
+	inline void RecordFree(HostMemoryTracker::Counter& counter, std::size_t size)
+	{
+		AddRelaxed(counter.freeCount, 1);
+		AddRelaxed(counter.freedBytes, static_cast<cct::Int64>(size));
+	}
+}
+
+inline cct::UInt32 HostMemoryTracker::GetSizeClass(std::size_t size)
+{
+	if (size <= 1)
+		return 0;
+	auto sizeClass = static_cast<cct::UInt32>(std::bit_width(size - 1));
+	return sizeClass < SizeClassCount ? sizeClass : SizeClassCount - 1;
+}
+
+inline void HostMemoryTracker::RecordAllocation(cct::UInt32 commandIndex, VkSystemAllocationScope scope, std::size_t size)
+{
+	ThreadCounters& counters = GetThreadCounters();
+	vmi::detail::RecordAllocation(counters.scopes[static_cast<cct::UInt32>(scope) < ScopeCount ? scope : 0], size);
+	vmi::detail::RecordAllocation(counters.commands[commandIndex < MaxCommands ? commandIndex : UnknownCommand], size);
+	vmi::detail::RecordAllocation(counters.sizeClasses[GetSizeClass(size)], size);
+}
+
+inline void HostMemoryTracker::RecordFree(cct::UInt32 commandIndex, VkSystemAllocationScope scope, std::size_t size)
+{
+	ThreadCounters& counters = GetThreadCounters();
+	vmi::detail::RecordFree(counters.scopes[static_cast<cct::UInt32>(scope) < ScopeCount ? scope : 0], size);
+	vmi::detail::RecordFree(counters.commands[commandIndex < MaxCommands ? commandIndex : UnknownCommand], size);
+	vmi::detail::RecordFree(counters.sizeClasses[GetSizeClass(size)], size);
+}
+
+inline void HostMemoryTracker::RecordInternalAllocation(cct::UInt32 commandIndex, VkInternalAllocationType type, VkSystemAllocationScope scope, std::size_t size)
+{
+	if (static_cast<cct::UInt32>(type) >= InternalTypeCount || static_cast<cct::UInt32>(scope) >= ScopeCount)
+		return;
+	ThreadCounters& counters = GetThreadCounters();
+	vmi::detail::RecordAllocation(counters.internal[type][scope], size);
+	vmi::detail::RecordAllocation(counters.internalCommands[commandIndex < MaxCommands ? commandIndex : UnknownCommand], size);
+}
+
+inline void HostMemoryTracker::RecordInternalFree(cct::UInt32 commandIndex, VkInternalAllocationType type, VkSystemAllocationScope scope, std::size_t size)
+{
+	if (static_cast<cct::UInt32>(type) >= InternalTypeCount || static_cast<cct::UInt32>(scope) >= ScopeCount)
+		return;
+	ThreadCounters& counters = GetThreadCounters();
+	vmi::detail::RecordFree(counters.internal[type][scope], size);
+	vmi::detail::RecordFree(counters.internalCommands[commandIndex < MaxCommands ? commandIndex : UnknownCommand], size);
+}
+
+#endif //VMI_HOSTMEMORYTRACKER_INL
@@ -0,0 +1,89 @@
+//
+// Created by arthur on 18/10/2026.
+//
+
+#ifndef VMI_MEMORYADVISOR_HPP
+#define VMI_MEMORYADVISOR_HPP
+
+#include <mutex>
+#include <optional>
+
+#include "VMI/Defines.hpp"
+#include "VMI/HandleTable.hpp"
+
+class MemoryAdvice;
+
+enum class AdvisedResourceKind : cct::UInt8
+{
+	Buffer,
+	Image,
+};
+
+struct AdvisedResource
+{
+	VkMemoryRequirements requirements;
+	VkDeviceSize requestedSize; // VkBufferCreateInfo::size, images have none
+	cct::UInt64 memory; // 0 until bound
+	cct::UInt64 allocationId; // AdvisedAllocation::id of memory, a freed allocation does not pass its resources to the next one reusing its handle
+	VkDeviceSize offset;
+	AdvisedResourceKind kind;
+	bool prefersDedicated; // prefersDedicatedAllocation or requiresDedicatedAllocation
+};
+
+struct AdvisedAllocation
+{
+	VkDeviceSize size;
+	cct::UInt64 id;
+	bool isDedicated;
+};
+
+/**
+ * @brief Bytes a device loses to its allocation pattern, to give targets to the application allocator.
+ *
+ * Buffers, images and device memory are recorded with their requirements and placement. When
+ * something changed, CollectAdvice walks the resources bound to each allocation in offset order:
+ * a gap smaller than the alignment of the next resource is alignment padding, the bytes no
+ * resource covers are unused. Allocations under the small allocation size that are not
+ * dedicated would rather be sub-allocated.
+ */
+class MemoryAdvisor
+{
+public:
+	/**
+	 * @param apiVersion Version the device is used with, the lowest of the instance and physical device ones
+	 */
+	MemoryAdvisor(VkDevice device, const VkPhysicalDeviceProperties& properties, cct::UInt32 apiVersion, VkDeviceSize smallAllocationSize);
+
+	void RecordAllocation(VkResult result, cct::UInt64 memory, VkDeviceSize size, bool isDedicated);
+	void RecordFree(cct::UInt64 memory);
+	void RecordResource(cct::UInt64 handle, AdvisedResourceKind kind, VkDeviceSize requestedSize, const VkMemoryRequirements& requirements, bool prefersDedicated);
+	void RecordBind(cct::UInt64 handle, cct::UInt64 memory, VkDeviceSize offset);
+	void RemoveResource(cct::UInt64 handle);
+
+	/**
+	 * @brief Summary of the live resources and allocations, nothing when unchanged since the previous call
+	 * unless isSnapshot. Resets the per frame counters.
+	 */
+	std::optional<MemoryAdvice> CollectAdvice(cct::Int32 frameIndex, bool isSnapshot);
+
+	/**
+	 * @brief Whether vkGet*MemoryRequirements2 are core in the version the device is used with, to query the dedicated requirements.
+	 */
+	bool HasMemoryRequirements2() const;
+
+private:
+	VkDevice _device;
+	VkDeviceSize _smallAllocationSize;
+	cct::UInt32 _maxMemoryAllocationCount;
+	bool _hasMemoryRequirements2;
+
+	std::mutex _mutex;
+	HandleTable<AdvisedResource> _resources;
+	HandleTable<AdvisedAllocation> _allocations;
+	cct::UInt64 _nextAllocationId;
+	cct::Int64 _peakAllocationCount;
+	cct::Int64 _pressureAllocationCount; // Allocations made at maxMemoryAllocationCount, since the last CollectAdvice
+	bool _hasChanged;
+};
+
+#endif //VMI_MEMORYADVISOR_HPP
@@ -0,0 +1,76 @@
+//
+// Created by arthur on 18/10/2026.
+//
+
+#ifndef VMI_OBJECTTRACKER_HPP
+#define VMI_OBJECTTRACKER_HPP
+
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "VMI/Defines.hpp"
+#include "VMI/HandleTable.hpp"
+
+class ObjectLeak;
+
+enum class TrackedObjectType : cct::UInt8
+{
+	DeviceMemory,
+	Buffer,
+	Image,
+	CommandPool,
+	DescriptorPool,
+	QueryPool,
+	Pipeline,
+
+	Count
+};
+
+std::string_view ToString(TrackedObjectType type);
+
+struct TrackedObject
+{
+	cct::UInt64 size;
+	cct::Int32 frameIndex;
+	TrackedObjectType type;
+};
+
+/**
+ * @brief Objects alive on one device, fed by the Post* hooks of the generated wrappers.
+ *
+ * Whatever is still tracked when the device, or its instance, is destroyed has leaked.
+ */
+class ObjectTracker
+{
+public:
+	ObjectTracker(VkDevice device, void* instance);
+
+	void Track(cct::UInt64 handle, TrackedObjectType type, cct::UInt64 size, cct::Int32 frameIndex);
+	void Untrack(cct::UInt64 handle);
+
+	/**
+	 * @brief Summarizes the objects still alive, one row per type that has any.
+	 */
+	std::vector<ObjectLeak> CollectLeaks(cct::Int32 frameIndex) const;
+
+	VkDevice GetDevice() const;
+	void* GetInstance() const;
+
+private:
+	VkDevice _device;
+	void* _instance;
+	mutable std::mutex _mutex;
+	HandleTable<TrackedObject> _objects;
+};
+
+/**
+ * @brief Tracks handle on the tracker of device, when the lifetime category is enabled. Null handles are ignored.
+ */
+void TrackObject(VkDevice device, cct::UInt64 handle, TrackedObjectType type, cct::UInt64 size);
+/**
+ * @brief Not gated by the category, objects tracked before it was turned off must not be reported as leaks.
+ */
+void UntrackObject(VkDevice device, cct::UInt64 handle);
+
+#endif //VMI_OBJECTTRACKER_HPP
@@ -0,0 +1,58 @@
+//
+// Created by arthur on 18/10/2026.
+//
+
+#ifndef VMI_PROCADDRTABLE_HPP
+#define VMI_PROCADDRTABLE_HPP
+
+#include <span>
+#include <string_view>
+
+#include "VMI/CaptureCategory.hpp"
+
+/**
+ * @brief Entry of the proc address table generated by gen_commands.py.
+ * function is null when the command is compiled out by its feature or extension guard.
+ */
+struct ProcAddrEntry
+{
+	std::string_view name;
+	PFN_vkVoidFunction function;
+	bool isInstanceCommand;
+	CaptureCategoryFlags categories;
+};
+
+/**
+ * @brief FNV-1a, seeded. Must match proc_addr_hash() in gen_commands.py.
+ */
+constexpr cct::UInt32 HashProcAddrName(std::string_view name, cct::UInt32 seed)
+{
+	cct::UInt32 hash = 2166136261u ^ seed;
+	for (char c : name)
+	{
+		hash ^= static_cast<cct::UInt8>(c);
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+/**
+ * @brief Looks up name in a hash-and-displace perfect hash table: the first hash selects a
+ * displacement, the second one the only slot the name can be in. One string comparison per lookup.
+ */
+inline const ProcAddrEntry* FindProcAddrEntry(std::span<const ProcAddrEntry> entries, std::span<const cct::UInt16> displacements, std::string_view name)
+{
+	cct::UInt32 bucket = HashProcAddrName(name, 0) % displacements.size();
+	cct::UInt32 slot = HashProcAddrName(name, displacements[bucket]) % entries.size();
+	const ProcAddrEntry& entry = entries[slot];
+	if (entry.name != name)
+		return nullptr;
+	return &entry;
+}
+
+/**
+ * @brief Looks up name in the generated table, defined in VulkanCommands.cpp.
+ */
+const ProcAddrEntry* FindProcAddrEntry(std::string_view name);
+
+#endif //VMI_PROCADDRTABLE_HPP
@@ -37,11 +37,11 @@
 		}
 
 
-#define VMI_GET_ALLOCATION_CALLBACKS(variableName)										\
+#define VMI_GET_ALLOCATION_CALLBACKS(variableName, command)								\
 	auto variableName = VulkanMemoryInspector::GetInstance()->GetAllocationCallbacks();	\
-	LowerAllocation lowerAllocation87 =													\
+	static LowerAllocation lowerAllocation87 =											\
 	{																					\
-		.allocationCallbacks = pAllocator												\
+		.commandIndex = HostMemoryTracker::RegisterCommand(command)						\
 	};																					\
 	variableName.pUserData = static_cast<void*>(&lowerAllocation87)
 
@@ -60,6 +60,13 @@ static cct::Int64 GetCurrentTimeStamp()
 	return duration_cast<microseconds>(duration).count();
 }
 
+// Monotonic, in nanoseconds, to measure the CPU time spent in a call
+static cct::Int64 GetSteadyTimeStamp()
+{
+	using namespace std::chrono;
+	return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
 static cct::Int64 GetCurrentThreadId()
 {
   auto id = std::this_thread::get_id();
@@ -5,15 +5,29 @@
 #ifndef VMI_VULKANMEMORYINTERCEPTOR_HPP
 #define VMI_VULKANMEMORYINTERCEPTOR_HPP
 
+#include <atomic>
 #include <mutex>
 #include <span>
+#include <string>
+#include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <Concerto/Core/Network/Socket.hpp>
 #include "VMI/VulkanCommands.hpp"
+#include "VMI/HostMemoryTracker.hpp"
+#include "VMI/CaptureCategory.hpp"
+#include "VMI/ControlMessage.hpp"
+#include "VMI/FrameTimeline.hpp"
+#include "VMI/ObjectTracker.hpp"
+#include "VMI/MemoryAdvisor.hpp"
 
+class QueueActivity;
+
+// pUserData of the layer allocation callbacks, one per call site so that it outlives the objects using it.
+// The callbacks of the application are replaced, its internal allocation notifications are not called either.
 struct LowerAllocation
 {
-	const VkAllocationCallbacks* allocationCallbacks;
+	cct::UInt32 commandIndex;
 };
 
 class VulkanMemoryInspector
@@ -25,14 +39,78 @@ public:
 	static void CreateInstance();
 	static void DestroyInstance();
 
-	void AddInstanceDispatchTable(void* instance, InstanceDispatchTable table);
+	void AddInstanceDispatchTable(void* instance, InstanceDispatchTable table, cct::UInt32 apiVersion);
 	void AddDeviceDispatchTable(void* device, DeviceDispatchTable table);
 	const InstanceDispatchTable* GetInstanceDispatchTable(void* instance);
 	const DeviceDispatchTable* GetDeviceDispatchTable(void* device);
+	/**
+	 * @brief VkApplicationInfo::apiVersion of the instance, VK_API_VERSION_1_0 when unknown.
+	 */
+	cct::UInt32 GetInstanceApiVersion(void* instance);
+	void AddObjectTracker(VkDevice device, void* instance);
+	ObjectTracker* GetObjectTracker(void* device);
+	/**
+	 * @param apiVersion The lowest of the instance and physical device versions, the one the device can be used with
+	 */
+	void AddMemoryAdvisor(VkDevice device, const VkPhysicalDeviceProperties& properties, cct::UInt32 apiVersion);
+	MemoryAdvisor* GetMemoryAdvisor(void* device);
+	/**
+	 * @brief Reports the objects device leaked and forgets its dispatch table, tracker and advisor.
+	 * The caller copies what it needs from the dispatch table beforehand.
+	 */
+	void ReleaseDevice(VkDevice device);
+	/**
+	 * @brief Same as ReleaseDevice for the instance, and for the devices it still owns, which leaked too.
+	 * @return The number of instances left
+	 */
+	std::size_t ReleaseInstance(VkInstance instance);
 	VkAllocationCallbacks GetAllocationCallbacks() const;
+	/**
+	 * @brief Frame index of the primary swapchain, the first one presented that is still alive.
+	 */
 	cct::Int32 GetFrameIndex() const;
 	void NextFrame();
+	/**
+	 * @brief Advances the swapchain timeline and publishes its frame timing when its window is over.
+	 * @param device Dispatch key of the device owning swapchain
+	 * @return true when swapchain is the primary one, i.e. when the global frame index must advance
+	 */
+	bool RecordPresent(void* device, VkSwapchainKHR swapchain);
+	/**
+	 * @brief Publishes the last partial window of the swapchain and forgets its timeline.
+	 */
+	void RemoveSwapchain(VkSwapchainKHR swapchain);
 	void Send(std::span<cct::Byte> memoryBlock);
+	void PublishHostMemoryUsage();
+	void PublishHostMemorySnapshot();
+	cct::Int64 GetStallThreshold() const;
+	void PublishQueueActivity(QueueActivity& activity, bool isBlocking);
+	/**
+	 * @brief Sends the vulkan_event of an intercepted command, callers check ShouldTrace first.
+	 * @param parameters The parameters of the call as a JSON object
+	 */
+	void SendVulkanEvent(std::string_view functionName, std::string parameters, cct::Int32 resultCode);
+	/**
+	 * @brief Publishes the memory advice of the devices whose resources or allocations changed.
+	 */
+	void PublishMemoryAdvice();
+	/**
+	 * @brief Publishes the memory advice of every device, changed or not.
+	 */
+	void PublishMemoryAdviceSnapshot();
+
+	/**
+	 * @brief Checked in the hot path, the control channel toggles the categories at runtime.
+	 * Static so that the driver allocation callbacks do not copy the instance, nothing is enabled without one.
+	 */
+	static bool IsCaptureEnabled(CaptureCategory category);
+	/**
+	 * @brief Whether an intercepted command emits its vulkan_event: api_trace is enabled, honoring the sampling rate.
+	 * The other categories only run their own hooks.
+	 */
+	bool ShouldTrace() const;
+	void SetCaptureCategories(CaptureCategoryFlags categories, bool enabled);
+	void SetTraceSamplingRate(cct::UInt32 samplingRate);
 
 private:
 	static void* AllocationFunction(void* pUserData, size_t size, size_t alignment, VkSystemAllocationScope allocationScope);
@@ -41,19 +119,48 @@ private:
 	static void InternalAllocationNotification(void* pUserData, size_t size, VkInternalAllocationType allocationType, VkSystemAllocationScope allocationScope);
 	static void InternalFreeNotification(void* pUserData, size_t size, VkInternalAllocationType allocationType, VkSystemAllocationScope allocationScope);
 
+	void ReceiveControlMessages();
+	bool Receive(void* buffer, std::size_t size);
+	void HandleControlMessage(const ControlMessage& message);
+	void PublishObjectLeaks(const ObjectTracker& tracker, bool isDeviceLeaked);
+	void SendMemoryAdvice(bool isSnapshot);
+	// Same as RemoveSwapchain for the swapchains the device did not destroy
+	void RemoveDeviceSwapchains(void* device);
+	// The earliest presented swapchain still alive, called with _frameTimelinesMutex held
+	void ElectPrimarySwapchain();
+	void PublishLastFrameTimings(std::span<const std::unique_ptr<FrameTimeline>> timelines);
+
 	static std::shared_ptr<VulkanMemoryInspector> instance;
+	static std::atomic<CaptureCategoryFlags> captureCategories; // Of the current instance, cleared by DestroyInstance
 
 	std::mutex instanceDispatchTablesMutex;
 	std::unordered_map<void*, InstanceDispatchTable> instanceDispatchTables;
+	std::unordered_map<void*, cct::UInt32> instanceApiVersions;
 
 	std::mutex deviceDispatchTablesMutex;
 	std::unordered_map<void*, DeviceDispatchTable> deviceDispatchTables;
 
+	std::mutex _objectTrackersMutex;
+	std::unordered_map<void*, std::unique_ptr<ObjectTracker>> _objectTrackers;
+
+	std::mutex _memoryAdvisorsMutex;
+	std::unordered_map<void*, std::unique_ptr<MemoryAdvisor>> _memoryAdvisors;
 
 	VkAllocationCallbacks _allocationCallbacks;
-	cct::Int32 _frameIndex;
+	std::atomic<cct::Int32> _frameIndex;
+	cct::Int64 _stallThreshold; // in nanoseconds
+	cct::Int64 _frameTimingPeriod; // in nanoseconds
+	VkDeviceSize _smallAllocationSize;
+	std::atomic<cct::UInt32> _traceSamplingRate;
+
+	std::mutex _frameTimelinesMutex;
+	std::unordered_map<VkSwapchainKHR, std::unique_ptr<FrameTimeline>> _frameTimelines;
+	VkSwapchainKHR _primarySwapchain;
+	cct::UInt64 _nextFrameTimelineOrder;
 
+	std::mutex _sendMutex;
 	std::unique_ptr<cct::net::Socket> _socket;
+	std::thread _controlThread;
 };
 
 #include "VMI/VulkanMemoryInspector.inl"
@@ -12,10 +12,11 @@ inline std::shared_ptr<VulkanMemoryInspector> VulkanMemoryInspector::GetInstance
 	return instance;
 }
 
-inline void VulkanMemoryInspector::AddInstanceDispatchTable(void* instance, InstanceDispatchTable table)
+inline void VulkanMemoryInspector::AddInstanceDispatchTable(void* instance, InstanceDispatchTable table, cct::UInt32 apiVersion)
 {
 	std::lock_guard _(instanceDispatchTablesMutex);
 	instanceDispatchTables.emplace(instance, table);
+	instanceApiVersions.emplace(instance, apiVersion);
 }
 
 inline void VulkanMemoryInspector::AddDeviceDispatchTable(void* device, DeviceDispatchTable table)
@@ -44,6 +45,36 @@ inline const DeviceDispatchTable* VulkanMemoryInspector::GetDeviceDispatchTable(
 	return &it->second;
 }
 
+inline cct::UInt32 VulkanMemoryInspector::GetInstanceApiVersion(void* instance)
+{
+	std::lock_guard _(instanceDispatchTablesMutex);
+
+	auto it = instanceApiVersions.find(instance);
+	if (it == instanceApiVersions.end())
+		return VK_API_VERSION_1_0;
+	return it->second;
+}
+
+inline ObjectTracker* VulkanMemoryInspector::GetObjectTracker(void* device)
+{
+	std::lock_guard _(_objectTrackersMutex);
+
+	auto it = _objectTrackers.find(device);
+	if (it == _objectTrackers.end())
+		return nullptr;
+	return it->second.get();
+}
+
+inline MemoryAdvisor* VulkanMemoryInspector::GetMemoryAdvisor(void* device)
+{
+	std::lock_guard _(_memoryAdvisorsMutex);
+
+	auto it = _memoryAdvisors.find(device);
+	if (it == _memoryAdvisors.end())
+		return nullptr;
+	return it->second.get();
+}
+
 inline VkAllocationCallbacks VulkanMemoryInspector::GetAllocationCallbacks() const
 {
 	return _allocationCallbacks;
@@ -51,22 +82,34 @@ inline VkAllocationCallbacks VulkanMemoryInspector::GetAllocationCallbacks() con
 
 inline cct::Int32 VulkanMemoryInspector::GetFrameIndex() const
 {
-	return _frameIndex;
+	return _frameIndex.load(std::memory_order_relaxed);
+}
+
+inline cct::Int64 VulkanMemoryInspector::GetStallThreshold() const
+{
+	return _stallThreshold;
 }
 
 inline void VulkanMemoryInspector::NextFrame()
 {
-	++_frameIndex;
+	_frameIndex.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline bool VulkanMemoryInspector::IsCaptureEnabled(CaptureCategory category)
+{
+	return HasCaptureCategory(captureCategories.load(std::memory_order_relaxed), category);
 }
 
-inline void VulkanMemoryInspector::Send(std::span<cct::Byte> memoryBlock)
+inline bool VulkanMemoryInspector::ShouldTrace() const
 {
-	if (!_socket)
-	{
-		CCT_ASSERT_FALSE("Invalid socket pointer");
-		return;
-	}
-	_socket->Send(memoryBlock.data(), memoryBlock.size());
+	if (!IsCaptureEnabled(CaptureCategory::ApiTrace))
+		return false;
+	cct::UInt32 samplingRate = _traceSamplingRate.load(std::memory_order_relaxed);
+	if (samplingRate <= 1)
+		return true;
+	// Counted per thread, a shared counter would be contended by every traced call
+	thread_local cct::UInt32 callCount = 0;
+	return ++callCount % samplingRate == 0;
 }
 
 inline void VulkanMemoryInspector::CreateInstance()
@@ -76,6 +119,7 @@ inline void VulkanMemoryInspector::CreateInstance()
 
 inline void VulkanMemoryInspector::DestroyInstance()
 {
+	captureCategories.store(0, std::memory_order_relaxed);
 	instance = nullptr;
 }
 
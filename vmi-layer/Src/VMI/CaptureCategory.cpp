@@ -0,0 +1,61 @@
+//
+// Created by arthur on 18/10/2026.
+//
+
+#include <array>
+#include <cstdlib>
+#include <utility>
+#include <Concerto/Core/Logger.hpp>
+
+#include "VMI/CaptureCategory.hpp"
+
+CaptureCategoryFlags ParseCaptureCategories(std::string_view categories)
+{
+	using namespace std::string_view_literals;
+	static constexpr std::array<std::pair<std::string_view, CaptureCategory>, 6> names = {{
+		{ "api_trace"sv, CaptureCategory::ApiTrace },
+		{ "memory"sv, CaptureCategory::Memory },
+		{ "command_buffer"sv, CaptureCategory::CommandBuffer },
+		{ "host_memory"sv, CaptureCategory::HostMemory },
+		{ "submission"sv, CaptureCategory::Submission },
+		{ "lifetime"sv, CaptureCategory::Lifetime },
+	}};
+
+	CaptureCategoryFlags flags = static_cast<CaptureCategoryFlags>(CaptureCategory::Core);
+	while (!categories.empty())
+	{
+		std::size_t separator = categories.find(',');
+		std::string_view name = categories.substr(0, separator);
+		categories = separator == std::string_view::npos ? std::string_view() : categories.substr(separator + 1);
+
+		if (name == "all"sv)
+			return AllCaptureCategories;
+		bool found = false;
+		for (const auto& [categoryName, category] : names)
+		{
+			if (categoryName != name)
+				continue;
+			flags |= static_cast<CaptureCategoryFlags>(category);
+			found = true;
+		}
+		if (!found && !name.empty())
+			cct::Logger::Warning("Unknown capture category '{}'", name);
+	}
+	return flags;
+}
+
+CaptureCategoryFlags GetStartupCaptureCategories()
+{
+	static const CaptureCategoryFlags categories = []()
+	{
+		const char* value = std::getenv("VMI_CAPTURE");
+		return value ? ParseCaptureCategories(value) : AllCaptureCategories;
+	}();
+	return categories;
+}
+
+CaptureCategoryFlags GetInitialCaptureCategories()
+{
+	const char* value = std::getenv("VMI_CAPTURE_ACTIVE");
+	return value ? ParseCaptureCategories(value) & GetStartupCaptureCategories() : GetStartupCaptureCategories();
+}
@@ -0,0 +1,73 @@
+//
+// Created by arthur on 18/10/2026.
+//
+
+#include "VMI/FrameTimeline.hpp"
+#include "VMI/VulkanFunctions.hpp"
+#include "VMI/Bindings.hpp"
+
+FrameTimeline::FrameTimeline(void* device, VkSwapchainKHR swapchain, cct::UInt64 creationOrder) :
+	_device(device),
+	_swapchain(swapchain),
+	_creationOrder(creationOrder),
+	_epoch(0),
+	_lastPresent(0),
+	_windowStart(0),
+	_windowFirstEpoch(0)
+{
+}
+
+bool FrameTimeline::RecordPresent(cct::Int64 timestamp, cct::Int64 period)
+{
+	// The first present only opens the window, there is no previous frame to measure against
+	if (_lastPresent != 0)
+		_histogram.Record(static_cast<cct::UInt64>(timestamp - _lastPresent) / 1000);
+	else
+		_windowStart = timestamp;
+	_lastPresent = timestamp;
+	_epoch.fetch_add(1, std::memory_order_relaxed);
+
+	return _histogram.GetCount() != 0 && timestamp - _windowStart >= period;
+}
+
+FrameTiming FrameTimeline::TakeWindow()
+{
+	cct::Int32 epoch = GetEpoch();
+	FrameTiming frameTiming = {
+		.id = 0,
+		.swapchain = reinterpret_cast<intptr_t>(_swapchain),
+		.firstFrameIndex = _windowFirstEpoch,
+		.lastFrameIndex = epoch - 1,
+		.frameCount = static_cast<cct::Int32>(_histogram.GetCount()),
+		.sentAt = GetCurrentTimeStamp(),
+		.minUs = static_cast<cct::Int64>(_histogram.GetMin()),
+		.p50Us = static_cast<cct::Int64>(_histogram.GetPercentile(50.0)),
+		.p95Us = static_cast<cct::Int64>(_histogram.GetPercentile(95.0)),
+		.p99Us = static_cast<cct::Int64>(_histogram.GetPercentile(99.0)),
+		.maxUs = static_cast<cct::Int64>(_histogram.GetMax()),
+	};
+	_histogram.Reset();
+	_windowStart = _lastPresent;
+	_windowFirstEpoch = epoch;
+	return frameTiming;
+}
+
+bool FrameTimeline::HasPendingWindow() const
+{
+	return _histogram.GetCount() != 0;
+}
+
+cct::Int32 FrameTimeline::GetEpoch() const
+{
+	return _epoch.load(std::memory_order_relaxed);
+}
+
+void* FrameTimeline::GetDevice() const
+{
+	return _device;
+}
+
+cct::UInt64 FrameTimeline::GetCreationOrder() const
+{
+	return _creationOrder;
+}
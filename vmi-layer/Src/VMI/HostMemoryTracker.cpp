@@ -0,0 +1,202 @@
+//
+// Created by arthur on 18/10/2026.
+//
+
+#include <string>
+#include <vulkan/vk_enum_string_helper.h>
+
+#include "VMI/HostMemoryTracker.hpp"
+#include "VMI/Bindings.hpp"
+
+namespace
+{
+	struct Totals
+	{
+		cct::Int64 allocationCount = 0;
+		cct::Int64 allocatedBytes = 0;
+		cct::Int64 freeCount = 0;
+		cct::Int64 freedBytes = 0;
+
+		bool operator==(const Totals&) const = default;
+
+		void Add(const HostMemoryTracker::Counter& counter)
+		{
+			allocationCount += counter.allocationCount.load(std::memory_order_relaxed);
+			allocatedBytes += counter.allocatedBytes.load(std::memory_order_relaxed);
+			freeCount += counter.freeCount.load(std::memory_order_relaxed);
+			freedBytes += counter.freedBytes.load(std::memory_order_relaxed);
+		}
+	};
+
+	struct Snapshot
+	{
+		std::array<Totals, HostMemoryTracker::ScopeCount> scopes;
+		std::array<Totals, HostMemoryTracker::MaxCommands> commands;
+		std::array<std::array<Totals, HostMemoryTracker::ScopeCount>, HostMemoryTracker::InternalTypeCount> internal;
+		std::array<Totals, HostMemoryTracker::MaxCommands> internalCommands;
+		std::array<Totals, HostMemoryTracker::SizeClassCount> sizeClasses;
+
+		void Add(const HostMemoryTracker::ThreadCounters& counters)
+		{
+			for (std::size_t i = 0; i < scopes.size(); ++i)
+				scopes[i].Add(counters.scopes[i]);
+			for (std::size_t i = 0; i < commands.size(); ++i)
+				commands[i].Add(counters.commands[i]);
+			for (std::size_t i = 0; i < internal.size(); ++i)
+				for (std::size_t j = 0; j < internal[i].size(); ++j)
+					internal[i][j].Add(counters.internal[i][j]);
+			for (std::size_t i = 0; i < internalCommands.size(); ++i)
+				internalCommands[i].Add(counters.internalCommands[i]);
+			for (std::size_t i = 0; i < sizeClasses.size(); ++i)
+				sizeClasses[i].Add(counters.sizeClasses[i]);
+		}
+	};
+
+	void Merge(HostMemoryTracker::Counter& destination, const HostMemoryTracker::Counter& source)
+	{
+		destination.allocationCount += source.allocationCount.load(std::memory_order_relaxed);
+		destination.allocatedBytes += source.allocatedBytes.load(std::memory_order_relaxed);
+		destination.freeCount += source.freeCount.load(std::memory_order_relaxed);
+		destination.freedBytes += source.freedBytes.load(std::memory_order_relaxed);
+	}
+
+	struct Registry
+	{
+		std::mutex mutex;
+		std::vector<HostMemoryTracker::ThreadCounters*> threads;
+		// Counters of the threads that exited, so that their allocations are still published
+		HostMemoryTracker::ThreadCounters retired;
+		std::array<std::string, HostMemoryTracker::MaxCommands> commandNames = { "Unknown" };
+		cct::UInt32 commandCount = 1;
+		Snapshot lastPublished;
+	};
+
+	Registry& GetRegistry()
+	{
+		static Registry registry;
+		return registry;
+	}
+
+	void AppendIfChanged(std::vector<HostMemoryUsage>& rows, cct::Int32 frameIndex, std::string_view category, std::string name, const Totals& current, const Totals& previous, bool includeUnchanged)
+	{
+		if (current == previous && (!includeUnchanged || current == Totals{}))
+			return;
+		rows.push_back(HostMemoryUsage{
+			.id = 0,
+			.frameIndex = frameIndex,
+			.category = std::string(category),
+			.name = std::move(name),
+			.allocationCount = current.allocationCount,
+			.allocatedBytes = current.allocatedBytes,
+			.freeCount = current.freeCount,
+			.freedBytes = current.freedBytes,
+		});
+	}
+}
+
+class ThreadCountersRegistration
+{
+public:
+	ThreadCountersRegistration()
+	{
+		HostMemoryTracker::RegisterThread(&counters);
+	}
+
+	~ThreadCountersRegistration()
+	{
+		HostMemoryTracker::UnregisterThread(&counters);
+	}
+
+	HostMemoryTracker::ThreadCounters counters;
+};
+
+HostMemoryTracker::ThreadCounters& HostMemoryTracker::GetThreadCounters()
+{
+	thread_local ThreadCountersRegistration registration;
+	return registration.counters;
+}
+
+void HostMemoryTracker::RegisterThread(ThreadCounters* counters)
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard _(registry.mutex);
+	registry.threads.push_back(counters);
+}
+
+void HostMemoryTracker::UnregisterThread(ThreadCounters* counters)
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard _(registry.mutex);
+	std::erase(registry.threads, counters);
+
+	for (std::size_t i = 0; i < ScopeCount; ++i)
+		Merge(registry.retired.scopes[i], counters->scopes[i]);
+	for (std::size_t i = 0; i < MaxCommands; ++i)
+		Merge(registry.retired.commands[i], counters->commands[i]);
+	for (std::size_t i = 0; i < InternalTypeCount; ++i)
+		for (std::size_t j = 0; j < ScopeCount; ++j)
+			Merge(registry.retired.internal[i][j], counters->internal[i][j]);
+	for (std::size_t i = 0; i < MaxCommands; ++i)
+		Merge(registry.retired.internalCommands[i], counters->internalCommands[i]);
+	for (std::size_t i = 0; i < SizeClassCount; ++i)
+		Merge(registry.retired.sizeClasses[i], counters->sizeClasses[i]);
+}
+
+cct::UInt32 HostMemoryTracker::RegisterCommand(std::string_view command)
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard _(registry.mutex);
+	for (cct::UInt32 i = 0; i < registry.commandCount; ++i)
+	{
+		if (registry.commandNames[i] == command)
+			return i;
+	}
+	if (registry.commandCount == MaxCommands)
+		return UnknownCommand;
+	registry.commandNames[registry.commandCount] = command;
+	return registry.commandCount++;
+}
+
+std::vector<HostMemoryUsage> HostMemoryTracker::CollectChanges(cct::Int32 frameIndex)
+{
+	return Collect(frameIndex, false);
+}
+
+std::vector<HostMemoryUsage> HostMemoryTracker::CollectSnapshot(cct::Int32 frameIndex)
+{
+	return Collect(frameIndex, true);
+}
+
+std::vector<HostMemoryUsage> HostMemoryTracker::Collect(cct::Int32 frameIndex, bool includeUnchanged)
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard _(registry.mutex);
+
+	Snapshot current;
+	current.Add(registry.retired);
+	for (const ThreadCounters* counters : registry.threads)
+		current.Add(*counters);
+
+	std::vector<HostMemoryUsage> rows;
+	const Snapshot& previous = registry.lastPublished;
+	for (cct::UInt32 i = 0; i < ScopeCount; ++i)
+		AppendIfChanged(rows, frameIndex, "scope", string_VkSystemAllocationScope(static_cast<VkSystemAllocationScope>(i)), current.scopes[i], previous.scopes[i], includeUnchanged);
+	for (cct::UInt32 i = 0; i < registry.commandCount; ++i)
+		AppendIfChanged(rows, frameIndex, "command", registry.commandNames[i], current.commands[i], previous.commands[i], includeUnchanged);
+	for (cct::UInt32 i = 0; i < InternalTypeCount; ++i)
+	{
+		for (cct::UInt32 j = 0; j < ScopeCount; ++j)
+		{
+			std::string name = std::string(string_VkInternalAllocationType(static_cast<VkInternalAllocationType>(i))) + "/" + string_VkSystemAllocationScope(static_cast<VkSystemAllocationScope>(j));
+			AppendIfChanged(rows, frameIndex, "internal", std::move(name), current.internal[i][j], previous.internal[i][j], includeUnchanged);
+		}
+	}
+	for (cct::UInt32 i = 0; i < registry.commandCount; ++i)
+		AppendIfChanged(rows, frameIndex, "internal_command", registry.commandNames[i], current.internalCommands[i], previous.internalCommands[i], includeUnchanged);
+	// Size classes are named after their upper bound in bytes
+	for (cct::UInt32 i = 0; i < SizeClassCount; ++i)
+		AppendIfChanged(rows, frameIndex, "size_class", std::to_string(1ull << i), current.sizeClasses[i], previous.sizeClasses[i], includeUnchanged);
+
+	registry.lastPublished = current;
+	return rows;
+}
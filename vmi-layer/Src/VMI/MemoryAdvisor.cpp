@@ -0,0 +1,215 @@
+//
+// Created by arthur on 18/10/2026.
+//
+
+#include <algorithm>
+#include <vector>
+
+#include "VMI/MemoryAdvisor.hpp"
+#include "VMI/Bindings.hpp"
+
+MemoryAdvisor::MemoryAdvisor(VkDevice device, const VkPhysicalDeviceProperties& properties, cct::UInt32 apiVersion, VkDeviceSize smallAllocationSize) :
+	_device(device),
+	_smallAllocationSize(smallAllocationSize),
+	_maxMemoryAllocationCount(properties.limits.maxMemoryAllocationCount),
+	_hasMemoryRequirements2(apiVersion >= VK_API_VERSION_1_1),
+	_nextAllocationId(1),
+	_peakAllocationCount(0),
+	_pressureAllocationCount(0),
+	_hasChanged(false)
+{
+}
+
+void MemoryAdvisor::RecordAllocation(VkResult result, cct::UInt64 memory, VkDeviceSize size, bool isDedicated)
+{
+	std::lock_guard _(_mutex);
+	if (result == VK_ERROR_TOO_MANY_OBJECTS)
+	{
+		++_pressureAllocationCount;
+		_hasChanged = true;
+	}
+	if (result != VK_SUCCESS)
+		return;
+
+	_allocations.Insert(memory, AdvisedAllocation{ size, _nextAllocationId++, isDedicated });
+	auto allocationCount = static_cast<cct::Int64>(_allocations.GetSize());
+	_peakAllocationCount = std::max(_peakAllocationCount, allocationCount);
+	if (_maxMemoryAllocationCount != 0 && allocationCount >= _maxMemoryAllocationCount)
+		++_pressureAllocationCount;
+	_hasChanged = true;
+}
+
+void MemoryAdvisor::RecordFree(cct::UInt64 memory)
+{
+	std::lock_guard _(_mutex);
+	_hasChanged |= _allocations.Erase(memory);
+}
+
+void MemoryAdvisor::RecordResource(cct::UInt64 handle, AdvisedResourceKind kind, VkDeviceSize requestedSize, const VkMemoryRequirements& requirements, bool prefersDedicated)
+{
+	std::lock_guard _(_mutex);
+	_resources.Insert(handle, AdvisedResource{
+		.requirements = requirements,
+		.requestedSize = requestedSize,
+		.memory = 0,
+		.allocationId = 0,
+		.offset = 0,
+		.kind = kind,
+		.prefersDedicated = prefersDedicated,
+	});
+	_hasChanged = true;
+}
+
+void MemoryAdvisor::RecordBind(cct::UInt64 handle, cct::UInt64 memory, VkDeviceSize offset)
+{
+	std::lock_guard _(_mutex);
+	AdvisedResource* resource = _resources.Find(handle);
+	if (!resource)
+		return;
+	// Memory allocated before the memory category was enabled is not known, its id of 0 matches no allocation
+	const AdvisedAllocation* allocation = _allocations.Find(memory);
+	resource->memory = memory;
+	resource->allocationId = allocation ? allocation->id : 0;
+	resource->offset = offset;
+	_hasChanged = true;
+}
+
+void MemoryAdvisor::RemoveResource(cct::UInt64 handle)
+{
+	std::lock_guard _(_mutex);
+	_hasChanged |= _resources.Erase(handle);
+}
+
+std::optional<MemoryAdvice> MemoryAdvisor::CollectAdvice(cct::Int32 frameIndex, bool isSnapshot)
+{
+	struct Placement
+	{
+		cct::UInt64 memory;
+		VkDeviceSize offset;
+		VkDeviceSize size;
+		VkDeviceSize alignment;
+		AdvisedResourceKind kind;
+	};
+
+	std::lock_guard _(_mutex);
+	if (!_hasChanged && !isSnapshot)
+		return std::nullopt;
+
+	MemoryAdvice advice = {
+		.id = 0,
+		.frameIndex = frameIndex,
+		.device = reinterpret_cast<intptr_t>(_device),
+		.bufferCount = 0,
+		.bufferRequestedBytes = 0,
+		.bufferSizePaddingBytes = 0,
+		.bufferAlignmentPaddingBytes = 0,
+		.imageCount = 0,
+		.imageBytes = 0,
+		.imageAlignmentPaddingBytes = 0,
+		.dedicatedPreferredCount = 0,
+		.dedicatedIgnoredCount = 0,
+		.dedicatedIgnoredBytes = 0,
+		.allocationCount = static_cast<cct::Int64>(_allocations.GetSize()),
+		.allocatedBytes = 0,
+		.unusedAllocatedBytes = 0,
+		.smallAllocationCount = 0,
+		.smallAllocationBytes = 0,
+		.allocationCountLimit = _maxMemoryAllocationCount,
+		.peakAllocationCount = _peakAllocationCount,
+		.pressureAllocationCount = _pressureAllocationCount,
+	};
+
+	std::vector<Placement> placements;
+	placements.reserve(_resources.GetSize());
+	_resources.ForEach([&](cct::UInt64, const AdvisedResource& resource)
+	{
+		auto size = static_cast<cct::Int64>(resource.requirements.size);
+		if (resource.kind == AdvisedResourceKind::Buffer)
+		{
+			++advice.bufferCount;
+			advice.bufferRequestedBytes += static_cast<cct::Int64>(resource.requestedSize);
+			advice.bufferSizePaddingBytes += std::max<cct::Int64>(size - static_cast<cct::Int64>(resource.requestedSize), 0);
+		}
+		else
+		{
+			++advice.imageCount;
+			advice.imageBytes += size;
+		}
+
+		// Nothing when unbound, or when the allocation was freed and its handle possibly reused
+		const AdvisedAllocation* allocation = resource.memory != 0 ? _allocations.Find(resource.memory) : nullptr;
+		if (allocation && allocation->id != resource.allocationId)
+			allocation = nullptr;
+
+		if (resource.prefersDedicated)
+		{
+			++advice.dedicatedPreferredCount;
+			if (allocation && !allocation->isDedicated)
+			{
+				++advice.dedicatedIgnoredCount;
+				advice.dedicatedIgnoredBytes += size;
+			}
+		}
+
+		if (allocation)
+			placements.push_back(Placement{ resource.memory, resource.offset, resource.requirements.size, resource.requirements.alignment, resource.kind });
+	});
+
+	std::ranges::sort(placements, [](const Placement& lhs, const Placement& rhs)
+	{
+		return lhs.memory != rhs.memory ? lhs.memory < rhs.memory : lhs.offset < rhs.offset;
+	});
+
+	// Bytes of the allocations covered by a resource or its alignment padding
+	cct::Int64 usedBytes = 0;
+	for (std::size_t first = 0; first < placements.size();)
+	{
+		cct::UInt64 memory = placements[first].memory;
+		VkDeviceSize end = 0;
+		VkDeviceSize covered = 0;
+		std::size_t last = first;
+		for (; last < placements.size() && placements[last].memory == memory; ++last)
+		{
+			const Placement& placement = placements[last];
+			// A larger gap is free space of the application allocator, not padding. Aliased resources overlap.
+			if (placement.offset >= end && placement.offset - end < placement.alignment)
+			{
+				auto padding = static_cast<cct::Int64>(placement.offset - end);
+				covered += placement.offset - end;
+				if (placement.kind == AdvisedResourceKind::Buffer)
+					advice.bufferAlignmentPaddingBytes += padding;
+				else
+					advice.imageAlignmentPaddingBytes += padding;
+			}
+			VkDeviceSize placementEnd = placement.offset + placement.size;
+			if (placementEnd > end)
+			{
+				covered += placementEnd - std::max(placement.offset, end);
+				end = placementEnd;
+			}
+		}
+		usedBytes += static_cast<cct::Int64>(std::min(covered, _allocations.Find(memory)->size));
+		first = last;
+	}
+
+	_allocations.ForEach([&](cct::UInt64, const AdvisedAllocation& allocation)
+	{
+		advice.allocatedBytes += static_cast<cct::Int64>(allocation.size);
+		if (!allocation.isDedicated && allocation.size < _smallAllocationSize)
+		{
+			++advice.smallAllocationCount;
+			advice.smallAllocationBytes += static_cast<cct::Int64>(allocation.size);
+		}
+	});
+	advice.unusedAllocatedBytes = advice.allocatedBytes - usedBytes;
+
+	_peakAllocationCount = advice.allocationCount;
+	_pressureAllocationCount = 0;
+	_hasChanged = false;
+	return advice;
+}
+
+bool MemoryAdvisor::HasMemoryRequirements2() const
+{
+	return _hasMemoryRequirements2;
+}
@@ -0,0 +1,91 @@
+//
+// Created by arthur on 18/10/2026.
+//
+
+#include "VMI/VulkanFunctions.hpp"
+#include "VMI/VulkanMemoryInspector.hpp"
+#include "VMI/ObjectTracker.hpp"
+
+// Post* hooks called by the generated wrappers of LIFETIME_COMMANDS (gen_commands.py),
+// device memory, buffers and images are handled with the memory advisor in VkAllocateMemory.cpp
+
+namespace
+{
+	void TrackPipelines(VkDevice device, uint32_t createInfoCount, const VkPipeline* pPipelines)
+	{
+		// On failure, or VK_PIPELINE_COMPILE_REQUIRED, the pipelines that were not created are VK_NULL_HANDLE
+		for (uint32_t i = 0; i < createInfoCount; ++i)
+			TrackObject(device, ToHandleKey(pPipelines[i]), TrackedObjectType::Pipeline, 0);
+	}
+}
+
+void PostCreateCommandPool(VkResult result, VkDevice device, const VkCommandPoolCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkCommandPool* pCommandPool)
+{
+	if (result == VK_SUCCESS)
+		TrackObject(device, ToHandleKey(*pCommandPool), TrackedObjectType::CommandPool, 0);
+}
+
+void PostDestroyCommandPool(VkDevice device, VkCommandPool commandPool, const VkAllocationCallbacks* pAllocator)
+{
+	UntrackObject(device, ToHandleKey(commandPool));
+}
+
+void PostCreateDescriptorPool(VkResult result, VkDevice device, const VkDescriptorPoolCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDescriptorPool* pDescriptorPool)
+{
+	if (result == VK_SUCCESS)
+		TrackObject(device, ToHandleKey(*pDescriptorPool), TrackedObjectType::DescriptorPool, 0);
+}
+
+void PostDestroyDescriptorPool(VkDevice device, VkDescriptorPool descriptorPool, const VkAllocationCallbacks* pAllocator)
+{
+	UntrackObject(device, ToHandleKey(descriptorPool));
+}
+
+void PostCreateQueryPool(VkResult result, VkDevice device, const VkQueryPoolCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkQueryPool* pQueryPool)
+{
+	if (result == VK_SUCCESS)
+		TrackObject(device, ToHandleKey(*pQueryPool), TrackedObjectType::QueryPool, 0);
+}
+
+void PostDestroyQueryPool(VkDevice device, VkQueryPool queryPool, const VkAllocationCallbacks* pAllocator)
+{
+	UntrackObject(device, ToHandleKey(queryPool));
+}
+
+void PostCreateGraphicsPipelines(VkResult result, VkDevice device, VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkGraphicsPipelineCreateInfo* pCreateInfos, const VkAllocationCallbacks* pAllocator, VkPipeline* pPipelines)
+{
+	TrackPipelines(device, createInfoCount, pPipelines);
+}
+
+void PostCreateComputePipelines(VkResult result, VkDevice device, VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkComputePipelineCreateInfo* pCreateInfos, const VkAllocationCallbacks* pAllocator, VkPipeline* pPipelines)
+{
+	TrackPipelines(device, createInfoCount, pPipelines);
+}
+
+#ifdef VK_KHR_ray_tracing_pipeline
+void PostCreateRayTracingPipelinesKHR(VkResult result, VkDevice device, VkDeferredOperationKHR deferredOperation, VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkRayTracingPipelineCreateInfoKHR* pCreateInfos, const VkAllocationCallbacks* pAllocator, VkPipeline* pPipelines)
+{
+	// A deferred creation only writes the handles once the operation completes, these pipelines are not tracked
+	if (result != VK_OPERATION_DEFERRED_KHR)
+		TrackPipelines(device, createInfoCount, pPipelines);
+}
+#endif // VK_KHR_ray_tracing_pipeline
+
+#ifdef VK_NV_ray_tracing
+void PostCreateRayTracingPipelinesNV(VkResult result, VkDevice device, VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkRayTracingPipelineCreateInfoNV* pCreateInfos, const VkAllocationCallbacks* pAllocator, VkPipeline* pPipelines)
+{
+	TrackPipelines(device, createInfoCount, pPipelines);
+}
+#endif // VK_NV_ray_tracing
+
+#ifdef VK_AMDX_shader_enqueue
+void PostCreateExecutionGraphPipelinesAMDX(VkResult result, VkDevice device, VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkExecutionGraphPipelineCreateInfoAMDX* pCreateInfos, const VkAllocationCallbacks* pAllocator, VkPipeline* pPipelines)
+{
+	TrackPipelines(device, createInfoCount, pPipelines);
+}
+#endif // VK_AMDX_shader_enqueue
+
+void PostDestroyPipeline(VkDevice device, VkPipeline pipeline, const VkAllocationCallbacks* pAllocator)
+{
+	UntrackObject(device, ToHandleKey(pipeline));
+}
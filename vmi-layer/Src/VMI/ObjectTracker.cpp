@@ -0,0 +1,112 @@
+//
+// Created by arthur on 18/10/2026.
+//
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+#include "VMI/ObjectTracker.hpp"
+#include "VMI/Bindings.hpp"
+#include "VMI/VulkanFunctions.hpp"
+#include "VMI/VulkanMemoryInspector.hpp"
+
+std::string_view ToString(TrackedObjectType type)
+{
+	using namespace std::string_view_literals;
+	static constexpr std::array<std::string_view, static_cast<std::size_t>(TrackedObjectType::Count)> names = {
+		"VkDeviceMemory"sv,
+		"VkBuffer"sv,
+		"VkImage"sv,
+		"VkCommandPool"sv,
+		"VkDescriptorPool"sv,
+		"VkQueryPool"sv,
+		"VkPipeline"sv,
+	};
+	return names[static_cast<std::size_t>(type)];
+}
+
+ObjectTracker::ObjectTracker(VkDevice device, void* instance) :
+	_device(device),
+	_instance(instance)
+{
+}
+
+void ObjectTracker::Track(cct::UInt64 handle, TrackedObjectType type, cct::UInt64 size, cct::Int32 frameIndex)
+{
+	std::lock_guard _(_mutex);
+	_objects.Insert(handle, TrackedObject{ size, frameIndex, type });
+}
+
+void ObjectTracker::Untrack(cct::UInt64 handle)
+{
+	std::lock_guard _(_mutex);
+	_objects.Erase(handle);
+}
+
+std::vector<ObjectLeak> ObjectTracker::CollectLeaks(cct::Int32 frameIndex) const
+{
+	struct Summary
+	{
+		cct::Int64 count = 0;
+		cct::Int64 bytes = 0;
+		cct::Int32 oldestFrameIndex = std::numeric_limits<cct::Int32>::max();
+	};
+	std::array<Summary, static_cast<std::size_t>(TrackedObjectType::Count)> summaries;
+
+	{
+		std::lock_guard _(_mutex);
+		_objects.ForEach([&](cct::UInt64, const TrackedObject& object)
+		{
+			Summary& summary = summaries[static_cast<std::size_t>(object.type)];
+			++summary.count;
+			summary.bytes += static_cast<cct::Int64>(object.size);
+			summary.oldestFrameIndex = std::min(summary.oldestFrameIndex, object.frameIndex);
+		});
+	}
+
+	std::vector<ObjectLeak> leaks;
+	for (std::size_t type = 0; type < summaries.size(); ++type)
+	{
+		const Summary& summary = summaries[type];
+		if (summary.count == 0)
+			continue;
+		leaks.push_back(ObjectLeak{
+			.id = 0,
+			.device = reinterpret_cast<intptr_t>(_device),
+			.objectType = std::string(ToString(static_cast<TrackedObjectType>(type))),
+			.leakedCount = summary.count,
+			.leakedBytes = summary.bytes,
+			.oldestFrameIndex = summary.oldestFrameIndex,
+			.frameIndex = frameIndex,
+		});
+	}
+	return leaks;
+}
+
+VkDevice ObjectTracker::GetDevice() const
+{
+	return _device;
+}
+
+void* ObjectTracker::GetInstance() const
+{
+	return _instance;
+}
+
+void TrackObject(VkDevice device, cct::UInt64 handle, TrackedObjectType type, cct::UInt64 size)
+{
+	auto inspector = VulkanMemoryInspector::GetInstance();
+	if (handle == 0 || !inspector->IsCaptureEnabled(CaptureCategory::Lifetime))
+		return;
+	if (ObjectTracker* tracker = inspector->GetObjectTracker(GetKey(device)))
+		tracker->Track(handle, type, size, inspector->GetFrameIndex());
+}
+
+void UntrackObject(VkDevice device, cct::UInt64 handle)
+{
+	if (handle == 0)
+		return;
+	if (ObjectTracker* tracker = VulkanMemoryInspector::GetInstance()->GetObjectTracker(GetKey(device)))
+		tracker->Untrack(handle);
+}
@@ -0,0 +1,96 @@
+//
+// Created by arthur on 18/10/2026.
+//
+
+#include <nlohmann/json.hpp>
+
+#include "VMI/Bindings.hpp"
+#include "VMI/VulkanFunctions.hpp"
+#include "VMI/VulkanMemoryInspector.hpp"
+
+namespace
+{
+	// Same parameters as the vulkan_event of the generated wrappers, pointers are sent as addresses
+	void TraceAcquireNextImageKHR(VkDevice device, VkSwapchainKHR swapchain, uint64_t timeout, VkSemaphore semaphore, VkFence fence, const uint32_t* pImageIndex, VkResult result)
+	{
+		if (!VulkanMemoryInspector::GetInstance()->ShouldTrace())
+			return;
+		nlohmann::json parameters = {{"device", reinterpret_cast<uintptr_t>(device)}, {"swapchain", reinterpret_cast<uintptr_t>(swapchain)}, {"timeout", timeout}, {"semaphore", reinterpret_cast<uintptr_t>(semaphore)}, {"fence", reinterpret_cast<uintptr_t>(fence)}, {"pImageIndex", reinterpret_cast<uintptr_t>(pImageIndex)}};
+		VulkanMemoryInspector::GetInstance()->SendVulkanEvent("vkAcquireNextImageKHR", parameters.dump(), static_cast<cct::Int32>(result));
+	}
+
+#if defined(VK_KHR_swapchain) && defined(VK_VERSION_1_1)
+	void TraceAcquireNextImage2KHR(VkDevice device, const VkAcquireNextImageInfoKHR* pAcquireInfo, const uint32_t* pImageIndex, VkResult result)
+	{
+		if (!VulkanMemoryInspector::GetInstance()->ShouldTrace())
+			return;
+		nlohmann::json parameters = {{"device", reinterpret_cast<uintptr_t>(device)}, {"pAcquireInfo", reinterpret_cast<uintptr_t>(pAcquireInfo)}, {"pImageIndex", reinterpret_cast<uintptr_t>(pImageIndex)}};
+		VulkanMemoryInspector::GetInstance()->SendVulkanEvent("vkAcquireNextImage2KHR", parameters.dump(), static_cast<cct::Int32>(result));
+	}
+#endif // VK_KHR_swapchain && VK_VERSION_1_1
+}
+
+VkResult vkAcquireNextImageKHR(VkDevice device, VkSwapchainKHR swapchain, uint64_t timeout, VkSemaphore semaphore, VkFence fence, uint32_t* pImageIndex)
+{
+	const auto* dp = VulkanMemoryInspector::GetInstance()->GetDeviceDispatchTable(GetKey(device));
+	if (!dp)
+	{
+		CCT_ASSERT_FALSE("Could not get the device dispatch table");
+		return VK_ERROR_INVALID_EXTERNAL_HANDLE;
+	}
+	if (!VulkanMemoryInspector::GetInstance()->IsCaptureEnabled(CaptureCategory::Submission))
+	{
+		VkResult result = dp->AcquireNextImageKHR(device, swapchain, timeout, semaphore, fence, pImageIndex);
+		TraceAcquireNextImageKHR(device, swapchain, timeout, semaphore, fence, pImageIndex, result);
+		return result;
+	}
+
+	QueueActivity activity = {
+		.id = 0,
+		.functionName = "vkAcquireNextImageKHR",
+		.queue = 0,
+		.startedAt = GetCurrentTimeStamp(),
+		.signalSemaphoreCount = semaphore != VK_NULL_HANDLE ? 1 : 0,
+	};
+	// Blocks when the presentation engine has no image available yet
+	cct::Int64 start = GetSteadyTimeStamp();
+	VkResult result = dp->AcquireNextImageKHR(device, swapchain, timeout, semaphore, fence, pImageIndex);
+	activity.cpuDurationNs = GetSteadyTimeStamp() - start;
+	activity.resultCode = static_cast<cct::Int32>(result);
+	VulkanMemoryInspector::GetInstance()->PublishQueueActivity(activity, true);
+	TraceAcquireNextImageKHR(device, swapchain, timeout, semaphore, fence, pImageIndex, result);
+	return result;
+}
+
+#if defined(VK_KHR_swapchain) && defined(VK_VERSION_1_1)
+VkResult vkAcquireNextImage2KHR(VkDevice device, const VkAcquireNextImageInfoKHR* pAcquireInfo, uint32_t* pImageIndex)
+{
+	const auto* dp = VulkanMemoryInspector::GetInstance()->GetDeviceDispatchTable(GetKey(device));
+	if (!dp)
+	{
+		CCT_ASSERT_FALSE("Could not get the device dispatch table");
+		return VK_ERROR_INVALID_EXTERNAL_HANDLE;
+	}
+	if (!VulkanMemoryInspector::GetInstance()->IsCaptureEnabled(CaptureCategory::Submission))
+	{
+		VkResult result = dp->AcquireNextImage2KHR(device, pAcquireInfo, pImageIndex);
+		TraceAcquireNextImage2KHR(device, pAcquireInfo, pImageIndex, result);
+		return result;
+	}
+
+	QueueActivity activity = {
+		.id = 0,
+		.functionName = "vkAcquireNextImage2KHR",
+		.queue = 0,
+		.startedAt = GetCurrentTimeStamp(),
+		.signalSemaphoreCount = pAcquireInfo->semaphore != VK_NULL_HANDLE ? 1 : 0,
+	};
+	cct::Int64 start = GetSteadyTimeStamp();
+	VkResult result = dp->AcquireNextImage2KHR(device, pAcquireInfo, pImageIndex);
+	activity.cpuDurationNs = GetSteadyTimeStamp() - start;
+	activity.resultCode = static_cast<cct::Int32>(result);
+	VulkanMemoryInspector::GetInstance()->PublishQueueActivity(activity, true);
+	TraceAcquireNextImage2KHR(device, pAcquireInfo, pImageIndex, result);
+	return result;
+}
+#endif // VK_KHR_swapchain && VK_VERSION_1_1
@@ -4,81 +4,194 @@
 
 #include "VMI/VulkanFunctions.hpp"
 #include "VMI/VulkanMemoryInspector.hpp"
-#include "VMI/Bindings.hpp"
-
-// VkResult vkAllocateMemory(VkDevice device, const VkMemoryAllocateInfo* pAllocateInfo, const VkAllocationCallbacks* pAllocator, VkDeviceMemory* pMemory)
-// {
-// 	const auto* dp = VulkanMemoryInspector::GetInstance()->GetDeviceDispatchTable(GetKey(device));
-// 	if (!dp)
-// 	{
-// 		CCT_ASSERT_FALSE("Could not get the device dispatch table");
-// 		return VK_ERROR_INVALID_EXTERNAL_HANDLE;
-// 	}
-
-// 	VkResult result = dp->AllocateMemory(device, pAllocateInfo, pAllocator, pMemory);
-// 	MemoryUsage memoryUsage = {
-// 		.id = 0,
-// 		.deviceMemory = reinterpret_cast<intptr_t>(*pMemory),
-// 		.frameIndexAllocated = VulkanMemoryInspector::GetInstance()->GetFrameIndex(),
-// 		.allocatedAt = GetCurrentTimeStamp(),
-// 		.allocationSize = static_cast<cct::Int64>(pAllocateInfo->allocationSize),
-// 		.frameIndexDeallocated = 0,
-// 		.deallocatedAt = 0,
-// 	};
-// 	auto buff = Serialize(memoryUsage);
-// 	VulkanMemoryInspector::GetInstance()->Send(buff);
-
-// 	return result;
-// }
-
-// void vkFreeMemory(VkDevice device, VkDeviceMemory memory, const VkAllocationCallbacks* pAllocator)
-// {
-// 	const auto* dp = VulkanMemoryInspector::GetInstance()->GetDeviceDispatchTable(GetKey(device));
-// 	if (!dp)
-// 	{
-// 		CCT_ASSERT_FALSE("Could not get the device dispatch table");
-// 		return;
-// 	}
-
-// 	dp->FreeMemory(device, memory, pAllocator);
-
-// 	MemoryUsage memoryUsage = {
-// 		.id = 0,
-// 		.deviceMemory = reinterpret_cast<intptr_t>(memory),
-// 		.frameIndexAllocated = 0,
-// 		.allocatedAt = 0,
-// 		.allocationSize = 0,
-// 		.frameIndexDeallocated = VulkanMemoryInspector::GetInstance()->GetFrameIndex(),
-// 		.deallocatedAt = GetCurrentTimeStamp(),
-// 	};
-// 	auto buff = Serialize(memoryUsage);
-// 	VulkanMemoryInspector::GetInstance()->Send(buff);
-// }
-
-// VkResult vkBindBufferMemory(VkDevice device, VkBuffer buffer, VkDeviceMemory memory, VkDeviceSize memoryOffset)
-// {
-// 	const auto* dp = VulkanMemoryInspector::GetInstance()->GetDeviceDispatchTable(GetKey(device));
-// 	if (!dp)
-// 	{
-// 		CCT_ASSERT_FALSE("Could not get the device dispatch table");
-// 		return VK_ERROR_INVALID_EXTERNAL_HANDLE;
-// 	}
-
-// 	VkResult result = dp->BindBufferMemory(device, buffer, memory, memoryOffset);
-
-// 	return result;
-// }
-
-// VkResult vkBindImageMemory(VkDevice device, VkImage image, VkDeviceMemory memory, VkDeviceSize memoryOffset)
-// {
-// 	const auto* dp = VulkanMemoryInspector::GetInstance()->GetDeviceDispatchTable(GetKey(device));
-// 	if (!dp)
-// 	{
-// 		CCT_ASSERT_FALSE("Could not get the device dispatch table");
-// 		return VK_ERROR_INVALID_EXTERNAL_HANDLE;
-// 	}
-
-// 	VkResult result = dp->BindImageMemory(device, image, memory, memoryOffset);
-
-// 	return result;
-// }
+
+// Post* hooks of device memory, buffers and images, they feed both the object tracker and the memory advisor
+
+namespace
+{
+	MemoryAdvisor* FindMemoryAdvisor(VkDevice device)
+	{
+		auto inspector = VulkanMemoryInspector::GetInstance();
+		if (!inspector->IsCaptureEnabled(CaptureCategory::Memory))
+			return nullptr;
+		return inspector->GetMemoryAdvisor(GetKey(device));
+	}
+
+	template<typename T>
+	const T* FindInPNextChain(const void* pNext, VkStructureType sType)
+	{
+		auto* structure = static_cast<const VkBaseInStructure*>(pNext);
+		while (structure && structure->sType != sType)
+			structure = structure->pNext;
+		return reinterpret_cast<const T*>(structure);
+	}
+
+	/**
+	 * @return Whether the driver prefers or requires a dedicated allocation, false when vkGet*MemoryRequirements2 are not there to tell
+	 */
+	template<typename Info, typename GetRequirements2, typename GetRequirements>
+	bool GetMemoryRequirements(const MemoryAdvisor* advisor, VkDevice device, Info info, GetRequirements2 getRequirements2, GetRequirements getRequirements, VkMemoryRequirements& requirements)
+	{
+		if (!advisor || !advisor->HasMemoryRequirements2() || !getRequirements2)
+		{
+			getRequirements(requirements);
+			return false;
+		}
+
+		VkMemoryDedicatedRequirements dedicatedRequirements = {
+			.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS,
+			.pNext = nullptr,
+			.prefersDedicatedAllocation = VK_FALSE,
+			.requiresDedicatedAllocation = VK_FALSE,
+		};
+		VkMemoryRequirements2 requirements2 = {
+			.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2,
+			.pNext = &dedicatedRequirements,
+			.memoryRequirements = {},
+		};
+		getRequirements2(device, &info, &requirements2);
+		requirements = requirements2.memoryRequirements;
+		return dedicatedRequirements.prefersDedicatedAllocation || dedicatedRequirements.requiresDedicatedAllocation;
+	}
+
+	/**
+	 * @brief Images imported from an Android hardware buffer, external format ones included, only have memory requirements once bound
+	 */
+	bool HasRequirementsAtCreation(const VkImageCreateInfo& createInfo)
+	{
+		const auto* externalInfo = FindInPNextChain<VkExternalMemoryImageCreateInfo>(createInfo.pNext, VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO);
+		return !externalInfo || (externalInfo->handleTypes & VK_EXTERNAL_MEMORY_HANDLE_TYPE_ANDROID_HARDWARE_BUFFER_BIT_ANDROID) == 0;
+	}
+
+	void RecordBind(VkDevice device, cct::UInt64 resource, VkDeviceMemory memory, VkDeviceSize offset)
+	{
+		// Swapchain images are bound without memory
+		if (memory == VK_NULL_HANDLE)
+			return;
+		if (MemoryAdvisor* advisor = FindMemoryAdvisor(device))
+			advisor->RecordBind(resource, ToHandleKey(memory), offset);
+	}
+
+	void RemoveResource(VkDevice device, cct::UInt64 resource)
+	{
+		UntrackObject(device, resource);
+		if (MemoryAdvisor* advisor = VulkanMemoryInspector::GetInstance()->GetMemoryAdvisor(GetKey(device)))
+			advisor->RemoveResource(resource);
+	}
+}
+
+void PostAllocateMemory(VkResult result, VkDevice device, const VkMemoryAllocateInfo* pAllocateInfo, const VkAllocationCallbacks* pAllocator, VkDeviceMemory* pMemory)
+{
+	if (MemoryAdvisor* advisor = FindMemoryAdvisor(device))
+	{
+		const auto* dedicatedInfo = FindInPNextChain<VkMemoryDedicatedAllocateInfo>(pAllocateInfo->pNext, VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO);
+		bool isDedicated = dedicatedInfo && (dedicatedInfo->buffer != VK_NULL_HANDLE || dedicatedInfo->image != VK_NULL_HANDLE);
+		advisor->RecordAllocation(result, result == VK_SUCCESS ? ToHandleKey(*pMemory) : 0, pAllocateInfo->allocationSize, isDedicated);
+	}
+	if (result == VK_SUCCESS)
+		TrackObject(device, ToHandleKey(*pMemory), TrackedObjectType::DeviceMemory, pAllocateInfo->allocationSize);
+}
+
+void PostFreeMemory(VkDevice device, VkDeviceMemory memory, const VkAllocationCallbacks* pAllocator)
+{
+	if (memory == VK_NULL_HANDLE)
+		return;
+	UntrackObject(device, ToHandleKey(memory));
+	if (MemoryAdvisor* advisor = VulkanMemoryInspector::GetInstance()->GetMemoryAdvisor(GetKey(device)))
+		advisor->RecordFree(ToHandleKey(memory));
+}
+
+void PostCreateBuffer(VkResult result, VkDevice device, const VkBufferCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkBuffer* pBuffer)
+{
+	if (result != VK_SUCCESS)
+		return;
+
+	TrackObject(device, ToHandleKey(*pBuffer), TrackedObjectType::Buffer, pCreateInfo->size);
+	MemoryAdvisor* advisor = FindMemoryAdvisor(device);
+	const auto* dp = VulkanMemoryInspector::GetInstance()->GetDeviceDispatchTable(GetKey(device));
+	if (!advisor || !dp)
+		return;
+
+	VkMemoryRequirements requirements = {};
+	VkBufferMemoryRequirementsInfo2 info = {
+		.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2,
+		.pNext = nullptr,
+		.buffer = *pBuffer,
+	};
+	bool prefersDedicated = GetMemoryRequirements(advisor, device, info, dp->GetBufferMemoryRequirements2,
+		[&](VkMemoryRequirements& out) { dp->GetBufferMemoryRequirements(device, *pBuffer, &out); }, requirements);
+	advisor->RecordResource(ToHandleKey(*pBuffer), AdvisedResourceKind::Buffer, pCreateInfo->size, requirements, prefersDedicated);
+}
+
+void PostDestroyBuffer(VkDevice device, VkBuffer buffer, const VkAllocationCallbacks* pAllocator)
+{
+	if (buffer != VK_NULL_HANDLE)
+		RemoveResource(device, ToHandleKey(buffer));
+}
+
+void PostCreateImage(VkResult result, VkDevice device, const VkImageCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkImage* pImage)
+{
+	if (result != VK_SUCCESS)
+		return;
+
+	// The size of an image is only known from its memory requirements, which disjoint
+	// multi-planar images only have per plane
+	auto inspector = VulkanMemoryInspector::GetInstance();
+	const auto* dp = inspector->GetDeviceDispatchTable(GetKey(device));
+	if (!dp || (pCreateInfo->flags & VK_IMAGE_CREATE_DISJOINT_BIT) != 0 || !HasRequirementsAtCreation(*pCreateInfo))
+	{
+		TrackObject(device, ToHandleKey(*pImage), TrackedObjectType::Image, 0);
+		return;
+	}
+	MemoryAdvisor* advisor = FindMemoryAdvisor(device);
+	if (!advisor && !inspector->IsCaptureEnabled(CaptureCategory::Lifetime))
+		return;
+
+	VkMemoryRequirements requirements = {};
+	VkImageMemoryRequirementsInfo2 info = {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2,
+		.pNext = nullptr,
+		.image = *pImage,
+	};
+	bool prefersDedicated = GetMemoryRequirements(advisor, device, info, dp->GetImageMemoryRequirements2,
+		[&](VkMemoryRequirements& out) { dp->GetImageMemoryRequirements(device, *pImage, &out); }, requirements);
+	TrackObject(device, ToHandleKey(*pImage), TrackedObjectType::Image, requirements.size);
+	if (advisor)
+		advisor->RecordResource(ToHandleKey(*pImage), AdvisedResourceKind::Image, 0, requirements, prefersDedicated);
+}
+
+void PostDestroyImage(VkDevice device, VkImage image, const VkAllocationCallbacks* pAllocator)
+{
+	if (image != VK_NULL_HANDLE)
+		RemoveResource(device, ToHandleKey(image));
+}
+
+void PostBindBufferMemory(VkResult result, VkDevice device, VkBuffer buffer, VkDeviceMemory memory, VkDeviceSize memoryOffset)
+{
+	if (result == VK_SUCCESS)
+		RecordBind(device, ToHandleKey(buffer), memory, memoryOffset);
+}
+
+void PostBindBufferMemory2(VkResult result, VkDevice device, uint32_t bindInfoCount, const VkBindBufferMemoryInfo* pBindInfos)
+{
+	// On failure, which of the bindings happened is undefined
+	if (result != VK_SUCCESS)
+		return;
+	for (uint32_t i = 0; i < bindInfoCount; ++i)
+		RecordBind(device, ToHandleKey(pBindInfos[i].buffer), pBindInfos[i].memory, pBindInfos[i].memoryOffset);
+}
+
+void PostBindImageMemory(VkResult result, VkDevice device, VkImage image, VkDeviceMemory memory, VkDeviceSize memoryOffset)
+{
+	if (result == VK_SUCCESS)
+		RecordBind(device, ToHandleKey(image), memory, memoryOffset);
+}
+
+void PostBindImageMemory2(VkResult result, VkDevice device, uint32_t bindInfoCount, const VkBindImageMemoryInfo* pBindInfos)
+{
+	if (result != VK_SUCCESS)
+		return;
+	// Planes of disjoint images are bound separately, these images are not advised
+	for (uint32_t i = 0; i < bindInfoCount; ++i)
+		RecordBind(device, ToHandleKey(pBindInfos[i].image), pBindInfos[i].memory, pBindInfos[i].memoryOffset);
+}
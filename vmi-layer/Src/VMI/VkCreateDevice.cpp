@@ -2,6 +2,8 @@
 // Created by arthur on 01/03/2025.
 //
 
+#include <algorithm>
+
 #include "VMI/VulkanFunctions.hpp"
 #include "VMI/VulkanMemoryInspector.hpp"
 
@@ -21,14 +23,23 @@ VkResult vkCreateDevice(VkPhysicalDevice physicalDevice, const VkDeviceCreateInf
 
 	layerCreateInfo->u.pLayerInfo = layerCreateInfo->u.pLayerInfo->pNext;
 
-	VkResult result = createDevice(physicalDevice, pCreateInfo, pAllocator, pDevice);
+	VMI_GET_ALLOCATION_CALLBACKS(allocationCallbacks, "vkCreateDevice");
+	VkResult result = createDevice(physicalDevice, pCreateInfo, &allocationCallbacks, pDevice);
 	if (result != VK_SUCCESS)
 		return result;
 
 	DeviceDispatchTable dispatchTable(*pDevice, getDeviceProcAddr);
 
+	// Physical devices share the dispatch key of their instance
+	VkPhysicalDeviceProperties properties = {};
+	if (const auto* instanceDp = VulkanMemoryInspector::GetInstance()->GetInstanceDispatchTable(GetKey(physicalDevice)))
+		instanceDp->GetPhysicalDeviceProperties(physicalDevice, &properties);
+	cct::UInt32 apiVersion = std::min(VulkanMemoryInspector::GetInstance()->GetInstanceApiVersion(GetKey(physicalDevice)), properties.apiVersion);
+
 	VMI_CATCH_AND_RETURN(
 		VulkanMemoryInspector::GetInstance()->AddDeviceDispatchTable(GetKey(*pDevice), std::move(dispatchTable));
+		VulkanMemoryInspector::GetInstance()->AddObjectTracker(*pDevice, GetKey(physicalDevice));
+		VulkanMemoryInspector::GetInstance()->AddMemoryAdvisor(*pDevice, properties, apiVersion);
 	, VK_ERROR_INITIALIZATION_FAILED, vkCreateDevice(physicalDevice, pCreateInfo, pAllocator, pDevice));
 
 	return VK_SUCCESS;
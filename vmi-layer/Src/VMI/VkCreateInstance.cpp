@@ -41,7 +41,7 @@ VkResult vkCreateInstance(const VkInstanceCreateInfo* pCreateInfo, const VkAlloc
 
 	if (!VulkanMemoryInspector::GetInstance())
 		VulkanMemoryInspector::CreateInstance();
-	VMI_GET_ALLOCATION_CALLBACKS(allocationCallbacks);
+	VMI_GET_ALLOCATION_CALLBACKS(allocationCallbacks, "vkCreateInstance");
 
 	result = createInstanceFunc(pCreateInfo, &allocationCallbacks, pInstance);
 	if (result != VK_SUCCESS)
@@ -51,9 +51,11 @@ VkResult vkCreateInstance(const VkInstanceCreateInfo* pCreateInfo, const VkAlloc
 	}
 
 	InstanceDispatchTable dispatchTable(*pInstance, getProcAddr);
+	// Device level commands of a later version than the instance one must not be used, even when the device has them
+	cct::UInt32 apiVersion = pCreateInfo->pApplicationInfo && pCreateInfo->pApplicationInfo->apiVersion != 0 ? pCreateInfo->pApplicationInfo->apiVersion : VK_API_VERSION_1_0;
 
 	VMI_CATCH_AND_RETURN(
-		VulkanMemoryInspector::GetInstance()->AddInstanceDispatchTable(GetKey(*pInstance), std::move(dispatchTable));
+		VulkanMemoryInspector::GetInstance()->AddInstanceDispatchTable(GetKey(*pInstance), std::move(dispatchTable), apiVersion);
 	, VK_ERROR_INITIALIZATION_FAILED, vkCreateInstance(pCreateInfo, pAllocator, pInstance));
 
 	return VK_SUCCESS;
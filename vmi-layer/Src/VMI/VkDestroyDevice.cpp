@@ -2,11 +2,27 @@
 // Created by arthur on 01/03/2025.
 //
 
-
-#include "VMI/VulkanCommands.hpp"
-
+#include "VMI/VulkanFunctions.hpp"
+#include "VMI/VulkanMemoryInspector.hpp"
 
 void vkDestroyDevice(VkDevice device, const VkAllocationCallbacks* pAllocator)
 {
-	CCT_ASSERT_FALSE("");
+	if (device == VK_NULL_HANDLE)
+		return;
+
+	auto vmiInstance = VulkanMemoryInspector::GetInstance();
+	const auto* dp = vmiInstance->GetDeviceDispatchTable(GetKey(device));
+	if (!dp)
+	{
+		CCT_ASSERT_FALSE("Could not get the device dispatch table");
+		return;
+	}
+
+	// The dispatch table goes away with the layer state of the device
+	PFN_vkDestroyDevice destroyDevice = dp->DestroyDevice;
+	vmiInstance->ReleaseDevice(device);
+
+	// vkCreateDevice always substitutes the layer callbacks
+	VMI_GET_ALLOCATION_CALLBACKS(allocationCallbacks, "vkDestroyDevice");
+	destroyDevice(device, &allocationCallbacks);
 }
@@ -2,12 +2,30 @@
 // Created by arthur on 01/03/2025.
 //
 
-
 #include "VMI/VulkanFunctions.hpp"
 #include "VMI/VulkanMemoryInspector.hpp"
+
 void vkDestroyInstance(VkInstance instance, const VkAllocationCallbacks* pAllocator)
 {
+	if (instance == VK_NULL_HANDLE)
+		return;
+
 	auto vmiInstance = VulkanMemoryInspector::GetInstance();
-	if (vmiInstance.use_count() == 1)
+	const auto* dp = vmiInstance->GetInstanceDispatchTable(GetKey(instance));
+	if (!dp)
+	{
+		CCT_ASSERT_FALSE("Could not get the instance dispatch table");
+		return;
+	}
+
+	PFN_vkDestroyInstance destroyInstance = dp->DestroyInstance;
+	std::size_t instanceCount = vmiInstance->ReleaseInstance(instance);
+
+	// vkCreateInstance always substitutes the layer callbacks
+	VMI_GET_ALLOCATION_CALLBACKS(allocationCallbacks, "vkDestroyInstance");
+	destroyInstance(instance, &allocationCallbacks);
+
+	// The last reference, held by vmiInstance, closes the socket once this function returns
+	if (instanceCount == 0)
 		VulkanMemoryInspector::DestroyInstance();
 }
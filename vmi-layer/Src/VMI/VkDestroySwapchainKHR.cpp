@@ -0,0 +1,42 @@
+//
+// Created by arthur on 18/10/2026.
+//
+
+#include <nlohmann/json.hpp>
+
+#include "VMI/ProcAddrTable.hpp"
+#include "VMI/VulkanFunctions.hpp"
+#include "VMI/VulkanMemoryInspector.hpp"
+
+void vkDestroySwapchainKHR(VkDevice device, VkSwapchainKHR swapchain, const VkAllocationCallbacks* pAllocator)
+{
+	const auto* dp = VulkanMemoryInspector::GetInstance()->GetDeviceDispatchTable(GetKey(device));
+	if (!dp)
+	{
+		CCT_ASSERT_FALSE("Could not get the device dispatch table");
+		return;
+	}
+
+	VulkanMemoryInspector::GetInstance()->RemoveSwapchain(swapchain);
+
+	// Always routed to keep the timelines in sync, but the layer callbacks must only be used
+	// when vkCreateSwapchainKHR was routed too and substituted them at creation
+	static const bool isCreateRouted = []()
+	{
+		const ProcAddrEntry* entry = FindProcAddrEntry("vkCreateSwapchainKHR");
+		return entry && (entry->categories & GetStartupCaptureCategories()) != 0;
+	}();
+	if (isCreateRouted)
+	{
+		VMI_GET_ALLOCATION_CALLBACKS(allocationCallbacks, "vkDestroySwapchainKHR");
+		dp->DestroySwapchainKHR(device, swapchain, &allocationCallbacks);
+	}
+	else
+		dp->DestroySwapchainKHR(device, swapchain, pAllocator);
+
+	if (VulkanMemoryInspector::GetInstance()->ShouldTrace())
+	{
+		nlohmann::json parameters = {{"device", reinterpret_cast<uintptr_t>(device)}, {"swapchain", reinterpret_cast<uintptr_t>(swapchain)}, {"pAllocator", reinterpret_cast<uintptr_t>(pAllocator)}};
+		VulkanMemoryInspector::GetInstance()->SendVulkanEvent("vkDestroySwapchainKHR", parameters.dump(), 0);
+	}
+}
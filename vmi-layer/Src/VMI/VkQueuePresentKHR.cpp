@@ -17,12 +17,27 @@ VkResult vkQueuePresentKHR(VkQueue queue, const VkPresentInfoKHR* pPresentInfo)
 
 	VkResult result = dp->QueuePresentKHR(queue, pPresentInfo);
 
+	// Every swapchain keeps its own epoch, only the primary one moves the global frame index
+	bool isPrimaryPresent = false;
+	for (uint32_t i = 0; i < pPresentInfo->swapchainCount; ++i)
+	{
+		// A failed present did not reach the presentation engine, an out of date or suboptimal one may have been queued
+		VkResult swapchainResult = pPresentInfo->pResults ? pPresentInfo->pResults[i] : result;
+		if (swapchainResult < VK_SUCCESS && swapchainResult != VK_ERROR_OUT_OF_DATE_KHR)
+			continue;
+		isPrimaryPresent |= VulkanMemoryInspector::GetInstance()->RecordPresent(GetKey(queue), pPresentInfo->pSwapchains[i]);
+	}
+	if (!isPrimaryPresent)
+		return result;
+
 	FrameInformation frameInformation = {
 		.frameIndex = VulkanMemoryInspector::GetInstance()->GetFrameIndex(),
 		.startedAt = GetCurrentTimeStamp()
 	};
 	auto buff = Serialize(frameInformation);
 	VulkanMemoryInspector::GetInstance()->Send(buff);
+	VulkanMemoryInspector::GetInstance()->PublishHostMemoryUsage();
+	VulkanMemoryInspector::GetInstance()->PublishMemoryAdvice();
 	VulkanMemoryInspector::GetInstance()->NextFrame();
 	return result;
 }
\ No newline at end of file
@@ -0,0 +1,99 @@
+//
+// Created by arthur on 18/10/2026.
+//
+
+#include <nlohmann/json.hpp>
+
+#include "VMI/Bindings.hpp"
+#include "VMI/VulkanFunctions.hpp"
+#include "VMI/VulkanMemoryInspector.hpp"
+
+namespace
+{
+	// Same parameters as the vulkan_event of the generated wrappers, pointers are sent as addresses
+	void TraceQueueSubmit(std::string_view functionName, VkQueue queue, uint32_t submitCount, const void* pSubmits, VkFence fence, VkResult result)
+	{
+		if (!VulkanMemoryInspector::GetInstance()->ShouldTrace())
+			return;
+		nlohmann::json parameters = {{"queue", reinterpret_cast<uintptr_t>(queue)}, {"submitCount", submitCount}, {"pSubmits", reinterpret_cast<uintptr_t>(pSubmits)}, {"fence", reinterpret_cast<uintptr_t>(fence)}};
+		VulkanMemoryInspector::GetInstance()->SendVulkanEvent(functionName, parameters.dump(), static_cast<cct::Int32>(result));
+	}
+}
+
+VkResult vkQueueSubmit(VkQueue queue, uint32_t submitCount, const VkSubmitInfo* pSubmits, VkFence fence)
+{
+	const auto* dp = VulkanMemoryInspector::GetInstance()->GetDeviceDispatchTable(GetKey(queue));
+	if (!dp)
+	{
+		CCT_ASSERT_FALSE("Could not get the device dispatch table");
+		return VK_ERROR_INVALID_EXTERNAL_HANDLE;
+	}
+	if (!VulkanMemoryInspector::GetInstance()->IsCaptureEnabled(CaptureCategory::Submission))
+	{
+		VkResult result = dp->QueueSubmit(queue, submitCount, pSubmits, fence);
+		TraceQueueSubmit("vkQueueSubmit", queue, submitCount, pSubmits, fence, result);
+		return result;
+	}
+
+	QueueActivity activity = {
+		.id = 0,
+		.functionName = "vkQueueSubmit",
+		.queue = reinterpret_cast<intptr_t>(queue),
+		.startedAt = GetCurrentTimeStamp(),
+		.batchCount = static_cast<cct::Int32>(submitCount),
+	};
+	cct::Int64 start = GetSteadyTimeStamp();
+	VkResult result = dp->QueueSubmit(queue, submitCount, pSubmits, fence);
+	activity.cpuDurationNs = GetSteadyTimeStamp() - start;
+
+	for (uint32_t i = 0; i < submitCount; ++i)
+	{
+		activity.commandBufferCount += static_cast<cct::Int32>(pSubmits[i].commandBufferCount);
+		activity.waitSemaphoreCount += static_cast<cct::Int32>(pSubmits[i].waitSemaphoreCount);
+		activity.signalSemaphoreCount += static_cast<cct::Int32>(pSubmits[i].signalSemaphoreCount);
+	}
+	activity.resultCode = static_cast<cct::Int32>(result);
+	VulkanMemoryInspector::GetInstance()->PublishQueueActivity(activity, false);
+	TraceQueueSubmit("vkQueueSubmit", queue, submitCount, pSubmits, fence, result);
+	return result;
+}
+
+#ifdef VK_VERSION_1_3
+VkResult vkQueueSubmit2(VkQueue queue, uint32_t submitCount, const VkSubmitInfo2* pSubmits, VkFence fence)
+{
+	const auto* dp = VulkanMemoryInspector::GetInstance()->GetDeviceDispatchTable(GetKey(queue));
+	if (!dp)
+	{
+		CCT_ASSERT_FALSE("Could not get the device dispatch table");
+		return VK_ERROR_INVALID_EXTERNAL_HANDLE;
+	}
+	if (!VulkanMemoryInspector::GetInstance()->IsCaptureEnabled(CaptureCategory::Submission))
+	{
+		VkResult result = dp->QueueSubmit2(queue, submitCount, pSubmits, fence);
+		TraceQueueSubmit("vkQueueSubmit2", queue, submitCount, pSubmits, fence, result);
+		return result;
+	}
+
+	QueueActivity activity = {
+		.id = 0,
+		.functionName = "vkQueueSubmit2",
+		.queue = reinterpret_cast<intptr_t>(queue),
+		.startedAt = GetCurrentTimeStamp(),
+		.batchCount = static_cast<cct::Int32>(submitCount),
+	};
+	cct::Int64 start = GetSteadyTimeStamp();
+	VkResult result = dp->QueueSubmit2(queue, submitCount, pSubmits, fence);
+	activity.cpuDurationNs = GetSteadyTimeStamp() - start;
+
+	for (uint32_t i = 0; i < submitCount; ++i)
+	{
+		activity.commandBufferCount += static_cast<cct::Int32>(pSubmits[i].commandBufferInfoCount);
+		activity.waitSemaphoreCount += static_cast<cct::Int32>(pSubmits[i].waitSemaphoreInfoCount);
+		activity.signalSemaphoreCount += static_cast<cct::Int32>(pSubmits[i].signalSemaphoreInfoCount);
+	}
+	activity.resultCode = static_cast<cct::Int32>(result);
+	VulkanMemoryInspector::GetInstance()->PublishQueueActivity(activity, false);
+	TraceQueueSubmit("vkQueueSubmit2", queue, submitCount, pSubmits, fence, result);
+	return result;
+}
+#endif // VK_VERSION_1_3
@@ -0,0 +1,129 @@
+//
+// Created by arthur on 18/10/2026.
+//
+
+#include <nlohmann/json.hpp>
+
+#include "VMI/Bindings.hpp"
+#include "VMI/VulkanFunctions.hpp"
+#include "VMI/VulkanMemoryInspector.hpp"
+
+namespace
+{
+	// Same parameters as the vulkan_event of the generated wrappers, pointers are sent as addresses
+	void TraceWaitForFences(VkDevice device, uint32_t fenceCount, const VkFence* pFences, VkBool32 waitAll, uint64_t timeout, VkResult result)
+	{
+		if (!VulkanMemoryInspector::GetInstance()->ShouldTrace())
+			return;
+		nlohmann::json parameters = {{"device", reinterpret_cast<uintptr_t>(device)}, {"fenceCount", fenceCount}, {"pFences", reinterpret_cast<uintptr_t>(pFences)}, {"waitAll", waitAll}, {"timeout", timeout}};
+		VulkanMemoryInspector::GetInstance()->SendVulkanEvent("vkWaitForFences", parameters.dump(), static_cast<cct::Int32>(result));
+	}
+
+	void TraceQueueWaitIdle(VkQueue queue, VkResult result)
+	{
+		if (!VulkanMemoryInspector::GetInstance()->ShouldTrace())
+			return;
+		nlohmann::json parameters = {{"queue", reinterpret_cast<uintptr_t>(queue)}};
+		VulkanMemoryInspector::GetInstance()->SendVulkanEvent("vkQueueWaitIdle", parameters.dump(), static_cast<cct::Int32>(result));
+	}
+
+	void TraceDeviceWaitIdle(VkDevice device, VkResult result)
+	{
+		if (!VulkanMemoryInspector::GetInstance()->ShouldTrace())
+			return;
+		nlohmann::json parameters = {{"device", reinterpret_cast<uintptr_t>(device)}};
+		VulkanMemoryInspector::GetInstance()->SendVulkanEvent("vkDeviceWaitIdle", parameters.dump(), static_cast<cct::Int32>(result));
+	}
+}
+
+// The calls below block the CPU until the GPU catches up, they are flagged as stalls past VMI_STALL_THRESHOLD_US
+
+VkResult vkWaitForFences(VkDevice device, uint32_t fenceCount, const VkFence* pFences, VkBool32 waitAll, uint64_t timeout)
+{
+	const auto* dp = VulkanMemoryInspector::GetInstance()->GetDeviceDispatchTable(GetKey(device));
+	if (!dp)
+	{
+		CCT_ASSERT_FALSE("Could not get the device dispatch table");
+		return VK_ERROR_INVALID_EXTERNAL_HANDLE;
+	}
+	if (!VulkanMemoryInspector::GetInstance()->IsCaptureEnabled(CaptureCategory::Submission))
+	{
+		VkResult result = dp->WaitForFences(device, fenceCount, pFences, waitAll, timeout);
+		TraceWaitForFences(device, fenceCount, pFences, waitAll, timeout, result);
+		return result;
+	}
+
+	QueueActivity activity = {
+		.id = 0,
+		.functionName = "vkWaitForFences",
+		.queue = 0,
+		.startedAt = GetCurrentTimeStamp(),
+	};
+	cct::Int64 start = GetSteadyTimeStamp();
+	VkResult result = dp->WaitForFences(device, fenceCount, pFences, waitAll, timeout);
+	activity.cpuDurationNs = GetSteadyTimeStamp() - start;
+	activity.resultCode = static_cast<cct::Int32>(result);
+	VulkanMemoryInspector::GetInstance()->PublishQueueActivity(activity, true);
+	TraceWaitForFences(device, fenceCount, pFences, waitAll, timeout, result);
+	return result;
+}
+
+VkResult vkQueueWaitIdle(VkQueue queue)
+{
+	const auto* dp = VulkanMemoryInspector::GetInstance()->GetDeviceDispatchTable(GetKey(queue));
+	if (!dp)
+	{
+		CCT_ASSERT_FALSE("Could not get the device dispatch table");
+		return VK_ERROR_INVALID_EXTERNAL_HANDLE;
+	}
+	if (!VulkanMemoryInspector::GetInstance()->IsCaptureEnabled(CaptureCategory::Submission))
+	{
+		VkResult result = dp->QueueWaitIdle(queue);
+		TraceQueueWaitIdle(queue, result);
+		return result;
+	}
+
+	QueueActivity activity = {
+		.id = 0,
+		.functionName = "vkQueueWaitIdle",
+		.queue = reinterpret_cast<intptr_t>(queue),
+		.startedAt = GetCurrentTimeStamp(),
+	};
+	cct::Int64 start = GetSteadyTimeStamp();
+	VkResult result = dp->QueueWaitIdle(queue);
+	activity.cpuDurationNs = GetSteadyTimeStamp() - start;
+	activity.resultCode = static_cast<cct::Int32>(result);
+	VulkanMemoryInspector::GetInstance()->PublishQueueActivity(activity, true);
+	TraceQueueWaitIdle(queue, result);
+	return result;
+}
+
+VkResult vkDeviceWaitIdle(VkDevice device)
+{
+	const auto* dp = VulkanMemoryInspector::GetInstance()->GetDeviceDispatchTable(GetKey(device));
+	if (!dp)
+	{
+		CCT_ASSERT_FALSE("Could not get the device dispatch table");
+		return VK_ERROR_INVALID_EXTERNAL_HANDLE;
+	}
+	if (!VulkanMemoryInspector::GetInstance()->IsCaptureEnabled(CaptureCategory::Submission))
+	{
+		VkResult result = dp->DeviceWaitIdle(device);
+		TraceDeviceWaitIdle(device, result);
+		return result;
+	}
+
+	QueueActivity activity = {
+		.id = 0,
+		.functionName = "vkDeviceWaitIdle",
+		.queue = 0,
+		.startedAt = GetCurrentTimeStamp(),
+	};
+	cct::Int64 start = GetSteadyTimeStamp();
+	VkResult result = dp->DeviceWaitIdle(device);
+	activity.cpuDurationNs = GetSteadyTimeStamp() - start;
+	activity.resultCode = static_cast<cct::Int32>(result);
+	VulkanMemoryInspector::GetInstance()->PublishQueueActivity(activity, true);
+	TraceDeviceWaitIdle(device, result);
+	return result;
+}
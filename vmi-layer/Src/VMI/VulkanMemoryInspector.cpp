@@ -2,11 +2,40 @@
 // Created by arthur on 01/03/2025.
 //
 
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <vector>
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <sys/socket.h>
+#endif
 #include <mimalloc.h>
+#include <Concerto/Core/ByteSwap.hpp>
+#include <Concerto/Core/Logger.hpp>
 
 #include "VMI/VulkanMemoryInspector.hpp"
+#include "VMI/Bindings.hpp"
+#include "VMI/VulkanFunctions.hpp"
 
 std::shared_ptr<VulkanMemoryInspector> VulkanMemoryInspector::instance = nullptr;
+std::atomic<CaptureCategoryFlags> VulkanMemoryInspector::captureCategories = 0;
+
+namespace
+{
+	// close() does not wake up a thread blocked in recv() on the same socket, shutdown() makes it return 0
+	void ShutdownSocket(const cct::net::Socket& socket)
+	{
+#ifdef _WIN32
+		::shutdown(static_cast<SOCKET>(socket.GetNativeHandle()), SD_BOTH);
+#else
+		::shutdown(static_cast<int>(socket.GetNativeHandle()), SHUT_RDWR);
+#endif
+	}
+}
 
 VulkanMemoryInspector::VulkanMemoryInspector() :
 	_allocationCallbacks({
@@ -17,19 +46,194 @@ VulkanMemoryInspector::VulkanMemoryInspector() :
 							 .pfnInternalAllocation = &InternalAllocationNotification,
 							 .pfnInternalFree = &InternalFreeNotification
 							}),
-	_frameIndex(0)
+	_frameIndex(0),
+	_stallThreshold(1'000'000),
+	_frameTimingPeriod(1'000'000'000),
+	_smallAllocationSize(1024 * 1024),
+	_traceSamplingRate(1),
+	_primarySwapchain(VK_NULL_HANDLE),
+	_nextFrameTimelineOrder(0)
 {
 	using namespace std::string_view_literals;
+	if (const char* stallThreshold = std::getenv("VMI_STALL_THRESHOLD_US"))
+		_stallThreshold = std::strtoll(stallThreshold, nullptr, 10) * 1000;
+	if (const char* frameTimingPeriod = std::getenv("VMI_FRAME_TIMING_PERIOD_MS"))
+		_frameTimingPeriod = std::max<cct::Int64>(std::strtoll(frameTimingPeriod, nullptr, 10), 1) * 1'000'000;
+	if (const char* smallAllocationSize = std::getenv("VMI_SMALL_ALLOCATION_KB"))
+		_smallAllocationSize = std::strtoull(smallAllocationSize, nullptr, 10) * 1024;
+	captureCategories.store(GetInitialCaptureCategories(), std::memory_order_relaxed);
 	_socket = std::make_unique<cct::net::Socket>(cct::net::SocketType::Tcp, cct::net::IpProtocol::Ipv4);
 	_socket->Connect(cct::net::IpAddress("127.0.0.1"sv, 2104));
+	_controlThread = std::thread(&VulkanMemoryInspector::ReceiveControlMessages, this);
 }
 
 VulkanMemoryInspector::~VulkanMemoryInspector()
 {
+	// The pending Receive of the control thread fails once the socket is shut down
+	ShutdownSocket(*_socket);
+	if (_controlThread.joinable())
+		_controlThread.join();
 	_socket->Close();
 	_socket = nullptr;
 }
 
+void VulkanMemoryInspector::Send(std::span<cct::Byte> memoryBlock)
+{
+	if (!_socket)
+	{
+		CCT_ASSERT_FALSE("Invalid socket pointer");
+		return;
+	}
+
+	// Packets are prefixed by their big endian length so that the collector can split the stream.
+	// The frame is built in a per thread buffer to go out in a single send.
+	thread_local std::vector<cct::Byte> frame;
+	cct::UInt32 length = cct::ByteSwap(static_cast<cct::UInt32>(memoryBlock.size()));
+	frame.resize(sizeof(length) + memoryBlock.size());
+	std::memcpy(frame.data(), &length, sizeof(length));
+	std::memcpy(frame.data() + sizeof(length), memoryBlock.data(), memoryBlock.size());
+
+	std::lock_guard _(_sendMutex);
+	_socket->Send(frame.data(), frame.size());
+}
+
+void VulkanMemoryInspector::SetCaptureCategories(CaptureCategoryFlags categories, bool enabled)
+{
+	if (enabled)
+	{
+		if ((categories & ~GetStartupCaptureCategories()) != 0)
+			cct::Logger::Warning("Capture categories {:#x} were not routed at startup (VMI_CAPTURE), they stay off", categories & ~GetStartupCaptureCategories());
+		captureCategories.fetch_or(categories & GetStartupCaptureCategories(), std::memory_order_relaxed);
+	}
+	else
+		captureCategories.fetch_and(~categories | static_cast<CaptureCategoryFlags>(CaptureCategory::Core), std::memory_order_relaxed);
+}
+
+void VulkanMemoryInspector::SetTraceSamplingRate(cct::UInt32 samplingRate)
+{
+	_traceSamplingRate.store(std::max<cct::UInt32>(samplingRate, 1), std::memory_order_relaxed);
+}
+
+bool VulkanMemoryInspector::Receive(void* buffer, std::size_t size)
+{
+	auto* bytes = static_cast<cct::Byte*>(buffer);
+	while (size != 0)
+	{
+		auto received = _socket->Receive(bytes, size);
+		if (received <= 0)
+			return false;
+		bytes += received;
+		size -= static_cast<std::size_t>(received);
+	}
+	return true;
+}
+
+void VulkanMemoryInspector::ReceiveControlMessages()
+{
+	std::array<cct::Byte, ControlMessageSize> payload;
+	while (true)
+	{
+		cct::UInt32 length;
+		if (!Receive(&length, sizeof(length)))
+			return;
+		length = cct::ByteSwap(length);
+		if (length != ControlMessageSize)
+		{
+			cct::Logger::Error("Invalid control message of {} bytes, closing the control channel", length);
+			return;
+		}
+		if (!Receive(payload.data(), payload.size()))
+			return;
+
+		cct::UInt32 opcode;
+		cct::UInt32 argument;
+		cct::Int64 value;
+		std::memcpy(&opcode, payload.data(), sizeof(opcode));
+		std::memcpy(&argument, payload.data() + 4, sizeof(argument));
+		std::memcpy(&value, payload.data() + 8, sizeof(value));
+		HandleControlMessage(ControlMessage{
+			.opcode = static_cast<ControlOpcode>(cct::ByteSwap(opcode)),
+			.argument = cct::ByteSwap(argument),
+			.value = cct::ByteSwap(value)
+		});
+	}
+}
+
+void VulkanMemoryInspector::HandleControlMessage(const ControlMessage& message)
+{
+	switch (message.opcode)
+	{
+	case ControlOpcode::SetCaptureCategories:
+		SetCaptureCategories(message.argument, message.value != 0);
+		break;
+	case ControlOpcode::SetSamplingRate:
+		SetTraceSamplingRate(static_cast<cct::UInt32>(std::clamp<cct::Int64>(message.value, 1, std::numeric_limits<cct::UInt32>::max())));
+		break;
+	case ControlOpcode::RequestSnapshot:
+		if (HasCaptureCategory(message.argument, CaptureCategory::HostMemory))
+			PublishHostMemorySnapshot();
+		if (HasCaptureCategory(message.argument, CaptureCategory::Memory))
+			PublishMemoryAdviceSnapshot();
+		break;
+	default:
+		cct::Logger::Warning("Unknown control opcode {}", static_cast<cct::UInt32>(message.opcode));
+		break;
+	}
+}
+
+namespace
+{
+	// Stored in front of every allocation made through the layer callbacks,
+	// vkFree only gives back the pointer and the accounting needs the rest.
+	struct AllocationHeader
+	{
+		cct::UInt64 size;
+		cct::UInt32 offset;
+		cct::UInt16 commandIndex;
+		cct::UInt8 scope;
+		cct::UInt8 tracked; // host_memory capture was on at allocation time, the free is only accounted then
+	};
+	static_assert(sizeof(AllocationHeader) == 16);
+
+	std::size_t GetHeaderOffset(std::size_t alignment)
+	{
+		return std::max<std::size_t>(alignment, sizeof(AllocationHeader));
+	}
+
+	AllocationHeader* GetHeader(void* pMemory)
+	{
+		return static_cast<AllocationHeader*>(pMemory) - 1;
+	}
+
+	void* Allocate(const LowerAllocation& lowerAllocation, size_t size, size_t alignment, VkSystemAllocationScope allocationScope)
+	{
+		std::size_t offset = GetHeaderOffset(alignment);
+		auto* raw = static_cast<cct::Byte*>(mi_malloc_aligned(size + offset, std::max<std::size_t>(alignment, alignof(AllocationHeader))));
+		if (!raw)
+			return nullptr;
+
+		void* pMemory = raw + offset;
+		*GetHeader(pMemory) = AllocationHeader{
+			.size = size,
+			.offset = static_cast<cct::UInt32>(offset),
+			.commandIndex = static_cast<cct::UInt16>(lowerAllocation.commandIndex),
+			.scope = static_cast<cct::UInt8>(allocationScope),
+			.tracked = VulkanMemoryInspector::IsCaptureEnabled(CaptureCategory::HostMemory)
+		};
+		if (GetHeader(pMemory)->tracked)
+			HostMemoryTracker::RecordAllocation(lowerAllocation.commandIndex, allocationScope, size);
+		return pMemory;
+	}
+
+	void Free(void* pMemory)
+	{
+		const AllocationHeader* header = GetHeader(pMemory);
+		if (header->tracked)
+			HostMemoryTracker::RecordFree(header->commandIndex, static_cast<VkSystemAllocationScope>(header->scope), header->size);
+		mi_free(static_cast<cct::Byte*>(pMemory) - header->offset);
+	}
+}
+
 void* VulkanMemoryInspector::AllocationFunction(void* pUserData, size_t size, size_t alignment, VkSystemAllocationScope allocationScope)
 {
 	LowerAllocation* lowerAllocation = static_cast<LowerAllocation*>(pUserData);
@@ -39,10 +243,7 @@ void* VulkanMemoryInspector::AllocationFunction(void* pUserData, size_t size, si
 		return nullptr;
 	}
 
-	//if (lowerAllocation->allocationCallbacks && lowerAllocation->allocationCallbacks->pfnAllocation)
-	//	return lowerAllocation->allocationCallbacks->pfnAllocation(pUserData, size, alignment, allocationScope);
-
-	void* alloc = mi_malloc_aligned(size, alignment);
+	void* alloc = Allocate(*lowerAllocation, size, alignment, allocationScope);
 	if (!alloc)
 	{
 		CCT_ASSERT_FALSE("Could not allocate memory: size={}, alignment={}", size, alignment);
@@ -61,16 +262,26 @@ void* VulkanMemoryInspector::ReallocationFunction(void* pUserData, void* pOrigin
 		return nullptr;
 	}
 
-	if (lowerAllocation->allocationCallbacks && lowerAllocation->allocationCallbacks->pfnReallocation)
-		return lowerAllocation->allocationCallbacks->pfnReallocation(pUserData, pOriginal, size, alignment, allocationScope);
+	if (size == 0)
+	{
+		if (pOriginal)
+			Free(pOriginal);
+		return nullptr;
+	}
 
-	void* alloc = mi_realloc_aligned(pOriginal, size, alignment);
+	void* alloc = Allocate(*lowerAllocation, size, alignment, allocationScope);
 	if (!alloc)
 	{
 		CCT_ASSERT_FALSE("Could not allocate memory: size={}, alignment={}", size, alignment);
 		return nullptr;
 	}
 
+	if (pOriginal)
+	{
+		std::memcpy(alloc, pOriginal, std::min<std::size_t>(size, GetHeader(pOriginal)->size));
+		Free(pOriginal);
+	}
+
 	return alloc;
 }
 
@@ -82,9 +293,9 @@ void VulkanMemoryInspector::FreeFunction(void* pUserData, void* pMemory)
 		CCT_ASSERT_FALSE("Invalid pUserData pointer");
 		return;
 	}
-	//if (lowerAllocation->allocationCallbacks && lowerAllocation->allocationCallbacks->pfnFree)
-	//	return lowerAllocation->allocationCallbacks->pfnFree(pUserData, pMemory);
-	mi_free(pMemory);
+
+	if (pMemory)
+		Free(pMemory);
 }
 
 void VulkanMemoryInspector::InternalAllocationNotification(void* pUserData, size_t size, VkInternalAllocationType allocationType, VkSystemAllocationScope allocationScope)
@@ -96,8 +307,8 @@ void VulkanMemoryInspector::InternalAllocationNotification(void* pUserData, size
 		return;
 	}
 
-	if (lowerAllocation->allocationCallbacks && lowerAllocation->allocationCallbacks->pfnInternalAllocation)
-		return lowerAllocation->allocationCallbacks->pfnInternalAllocation(pUserData, size, allocationType, allocationScope);
+	if (IsCaptureEnabled(CaptureCategory::HostMemory))
+		HostMemoryTracker::RecordInternalAllocation(lowerAllocation->commandIndex, allocationType, allocationScope, size);
 }
 
 void VulkanMemoryInspector::InternalFreeNotification(void* pUserData, size_t size, VkInternalAllocationType allocationType, VkSystemAllocationScope allocationScope)
@@ -109,6 +320,266 @@ void VulkanMemoryInspector::InternalFreeNotification(void* pUserData, size_t siz
 		return;
 	}
 
-	if (lowerAllocation->allocationCallbacks && lowerAllocation->allocationCallbacks->pfnInternalFree)
-		return lowerAllocation->allocationCallbacks->pfnInternalFree(pUserData, size, allocationType, allocationScope);
+	if (IsCaptureEnabled(CaptureCategory::HostMemory))
+		HostMemoryTracker::RecordInternalFree(lowerAllocation->commandIndex, allocationType, allocationScope, size);
+}
+
+void VulkanMemoryInspector::PublishHostMemoryUsage()
+{
+	if (!IsCaptureEnabled(CaptureCategory::HostMemory))
+		return;
+	for (const HostMemoryUsage& usage : HostMemoryTracker::CollectChanges(GetFrameIndex()))
+	{
+		auto buff = Serialize(usage);
+		Send(buff);
+	}
+}
+
+void VulkanMemoryInspector::PublishHostMemorySnapshot()
+{
+	for (const HostMemoryUsage& usage : HostMemoryTracker::CollectSnapshot(GetFrameIndex()))
+	{
+		auto buff = Serialize(usage);
+		Send(buff);
+	}
+}
+
+void VulkanMemoryInspector::PublishQueueActivity(QueueActivity& activity, bool isBlocking)
+{
+	activity.frameIndex = GetFrameIndex();
+	activity.isStall = isBlocking && activity.cpuDurationNs >= _stallThreshold;
+	auto buff = Serialize(activity);
+	Send(buff);
+}
+
+void VulkanMemoryInspector::SendVulkanEvent(std::string_view functionName, std::string parameters, cct::Int32 resultCode)
+{
+	VulkanEvent vmiEvent = {
+		.id = 0,
+		.timestamp = GetCurrentTimeStamp(),
+		.frameNumber = GetFrameIndex(),
+		.functionName = std::string(functionName),
+		.parameters = std::move(parameters),
+		.resultCode = resultCode,
+		.threadId = GetCurrentThreadId(),
+	};
+	auto buff = Serialize(vmiEvent);
+	Send(buff);
+}
+
+bool VulkanMemoryInspector::RecordPresent(void* device, VkSwapchainKHR swapchain)
+{
+	FrameTimeline* timeline;
+	bool isPrimary;
+	{
+		std::lock_guard _(_frameTimelinesMutex);
+		auto it = _frameTimelines.find(swapchain);
+		if (it == _frameTimelines.end())
+			it = _frameTimelines.emplace(swapchain, std::make_unique<FrameTimeline>(device, swapchain, _nextFrameTimelineOrder++)).first;
+		if (_primarySwapchain == VK_NULL_HANDLE)
+			_primarySwapchain = swapchain;
+		timeline = it->second.get();
+		isPrimary = swapchain == _primarySwapchain;
+	}
+
+	// Presents to a swapchain are externally synchronized, the timeline is only touched by this thread
+	if (timeline->RecordPresent(GetSteadyTimeStamp(), _frameTimingPeriod))
+	{
+		FrameTiming frameTiming = timeline->TakeWindow();
+		auto buff = Serialize(frameTiming);
+		Send(buff);
+	}
+	return isPrimary;
+}
+
+void VulkanMemoryInspector::RemoveSwapchain(VkSwapchainKHR swapchain)
+{
+	std::vector<std::unique_ptr<FrameTimeline>> removed;
+	{
+		std::lock_guard _(_frameTimelinesMutex);
+		auto it = _frameTimelines.find(swapchain);
+		if (it == _frameTimelines.end())
+			return;
+		removed.push_back(std::move(it->second));
+		_frameTimelines.erase(it);
+		ElectPrimarySwapchain();
+	}
+	PublishLastFrameTimings(removed);
+}
+
+void VulkanMemoryInspector::RemoveDeviceSwapchains(void* device)
+{
+	std::vector<std::unique_ptr<FrameTimeline>> removed;
+	{
+		std::lock_guard _(_frameTimelinesMutex);
+		for (auto it = _frameTimelines.begin(); it != _frameTimelines.end();)
+		{
+			if (it->second->GetDevice() != device)
+			{
+				++it;
+				continue;
+			}
+			removed.push_back(std::move(it->second));
+			it = _frameTimelines.erase(it);
+		}
+		ElectPrimarySwapchain();
+	}
+	PublishLastFrameTimings(removed);
+}
+
+void VulkanMemoryInspector::ElectPrimarySwapchain()
+{
+	if (_frameTimelines.contains(_primarySwapchain))
+		return;
+	// The new primary swapchain keeps counting from the current frame index. With none left,
+	// the next swapchain to present becomes the primary one.
+	_primarySwapchain = VK_NULL_HANDLE;
+	cct::UInt64 primaryOrder = std::numeric_limits<cct::UInt64>::max();
+	for (const auto& [swapchain, timeline] : _frameTimelines)
+	{
+		if (timeline->GetCreationOrder() < primaryOrder)
+		{
+			_primarySwapchain = swapchain;
+			primaryOrder = timeline->GetCreationOrder();
+		}
+	}
+}
+
+void VulkanMemoryInspector::PublishLastFrameTimings(std::span<const std::unique_ptr<FrameTimeline>> timelines)
+{
+	for (const auto& timeline : timelines)
+	{
+		if (!timeline->HasPendingWindow())
+			continue;
+		FrameTiming frameTiming = timeline->TakeWindow();
+		auto buff = Serialize(frameTiming);
+		Send(buff);
+	}
+}
+
+void VulkanMemoryInspector::AddObjectTracker(VkDevice device, void* instance)
+{
+	std::lock_guard _(_objectTrackersMutex);
+	_objectTrackers.emplace(GetKey(device), std::make_unique<ObjectTracker>(device, instance));
+}
+
+void VulkanMemoryInspector::AddMemoryAdvisor(VkDevice device, const VkPhysicalDeviceProperties& properties, cct::UInt32 apiVersion)
+{
+	std::lock_guard _(_memoryAdvisorsMutex);
+	_memoryAdvisors.emplace(GetKey(device), std::make_unique<MemoryAdvisor>(device, properties, apiVersion, _smallAllocationSize));
+}
+
+void VulkanMemoryInspector::PublishMemoryAdvice()
+{
+	if (IsCaptureEnabled(CaptureCategory::Memory))
+		SendMemoryAdvice(false);
+}
+
+void VulkanMemoryInspector::PublishMemoryAdviceSnapshot()
+{
+	SendMemoryAdvice(true);
+}
+
+void VulkanMemoryInspector::SendMemoryAdvice(bool isSnapshot)
+{
+	cct::Int32 frameIndex = GetFrameIndex();
+	std::lock_guard _(_memoryAdvisorsMutex);
+	for (auto& [device, advisor] : _memoryAdvisors)
+	{
+		if (auto advice = advisor->CollectAdvice(frameIndex, isSnapshot))
+		{
+			auto buff = Serialize(*advice);
+			Send(buff);
+		}
+	}
+}
+
+void VulkanMemoryInspector::ReleaseDevice(VkDevice device)
+{
+	void* key = GetKey(device);
+	std::unique_ptr<ObjectTracker> tracker;
+	{
+		std::lock_guard _(_objectTrackersMutex);
+		auto it = _objectTrackers.find(key);
+		if (it != _objectTrackers.end())
+		{
+			tracker = std::move(it->second);
+			_objectTrackers.erase(it);
+		}
+	}
+	if (tracker)
+		PublishObjectLeaks(*tracker, false);
+
+	{
+		std::lock_guard _(_memoryAdvisorsMutex);
+		_memoryAdvisors.erase(key);
+	}
+	RemoveDeviceSwapchains(key);
+
+	std::lock_guard _(deviceDispatchTablesMutex);
+	deviceDispatchTables.erase(key);
+}
+
+std::size_t VulkanMemoryInspector::ReleaseInstance(VkInstance instance)
+{
+	void* key = GetKey(instance);
+	std::vector<std::unique_ptr<ObjectTracker>> leakedDevices;
+	{
+		std::lock_guard _(_objectTrackersMutex);
+		for (auto it = _objectTrackers.begin(); it != _objectTrackers.end();)
+		{
+			if (it->second->GetInstance() != key)
+			{
+				++it;
+				continue;
+			}
+			leakedDevices.push_back(std::move(it->second));
+			it = _objectTrackers.erase(it);
+		}
+	}
+	for (const auto& tracker : leakedDevices)
+	{
+		PublishObjectLeaks(*tracker, true);
+		void* deviceKey = GetKey(tracker->GetDevice());
+		{
+			std::lock_guard _(_memoryAdvisorsMutex);
+			_memoryAdvisors.erase(deviceKey);
+		}
+		RemoveDeviceSwapchains(deviceKey);
+		std::lock_guard _(deviceDispatchTablesMutex);
+		deviceDispatchTables.erase(deviceKey);
+	}
+
+	std::lock_guard _(instanceDispatchTablesMutex);
+	instanceDispatchTables.erase(key);
+	instanceApiVersions.erase(key);
+	return instanceDispatchTables.size();
+}
+
+void VulkanMemoryInspector::PublishObjectLeaks(const ObjectTracker& tracker, bool isDeviceLeaked)
+{
+	cct::Int32 frameIndex = GetFrameIndex();
+	std::vector<ObjectLeak> leaks = tracker.CollectLeaks(frameIndex);
+	if (isDeviceLeaked)
+	{
+		leaks.push_back(ObjectLeak{
+			.id = 0,
+			.device = reinterpret_cast<intptr_t>(tracker.GetDevice()),
+			.objectType = "VkDevice",
+			.leakedCount = 1,
+			.leakedBytes = 0,
+			.oldestFrameIndex = frameIndex,
+			.frameIndex = frameIndex,
+		});
+	}
+	if (leaks.empty())
+		return;
+
+	cct::Logger::Warning("Device {:#x} {} with leaked objects:", static_cast<cct::UInt64>(leaks.front().device), isDeviceLeaked ? "left alive by its instance" : "destroyed");
+	for (const ObjectLeak& leak : leaks)
+	{
+		cct::Logger::Warning("    {} x{}, {} bytes, oldest created at frame {}", leak.objectType, leak.leakedCount, leak.leakedBytes, leak.oldestFrameIndex);
+		auto buff = Serialize(leak);
+		Send(buff);
+	}
 }
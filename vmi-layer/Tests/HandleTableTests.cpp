@@ -0,0 +1,159 @@
+//
+// Created by arthur on 18/10/2026.
+//
+
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "VMI/HandleTable.hpp"
+
+#define VMI_CHECK(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+			return false; \
+		} \
+	} while (false)
+
+namespace
+{
+	// Must match HandleTable::GetHome while the index has its minimum capacity of 64 positions
+	std::size_t GetHome(cct::UInt64 handle)
+	{
+		return static_cast<std::size_t>((handle * 0x9E3779B97F4A7C15ull) >> 58);
+	}
+
+	std::vector<cct::UInt64> FindHandlesWithHome(std::size_t home, std::size_t count)
+	{
+		std::vector<cct::UInt64> handles;
+		for (cct::UInt64 handle = 1; handles.size() < count; ++handle)
+		{
+			if (GetHome(handle) == home)
+				handles.push_back(handle);
+		}
+		return handles;
+	}
+
+	bool Contains(const HandleTable<cct::UInt64>& table, const std::unordered_map<cct::UInt64, cct::UInt64>& expected)
+	{
+		VMI_CHECK(table.GetSize() == expected.size());
+		for (auto [handle, value] : expected)
+		{
+			const cct::UInt64* found = table.Find(handle);
+			VMI_CHECK(found && *found == value);
+		}
+		std::size_t visited = 0;
+		bool matches = true;
+		table.ForEach([&](cct::UInt64 handle, cct::UInt64 value)
+		{
+			auto it = expected.find(handle);
+			matches &= it != expected.end() && it->second == value;
+			++visited;
+		});
+		VMI_CHECK(matches && visited == expected.size());
+		return true;
+	}
+
+	// A run of colliding handles homed near the end of the index wraps around its start, past a handle
+	// already at its home there, and pushes the handles homed after it. Erasing must shift back every
+	// entry of the run over the hole except the one at its home.
+	bool TestCollisionsAndWraparound()
+	{
+		cct::UInt64 atStart = FindHandlesWithHome(0, 1)[0];
+		std::vector<cct::UInt64> wrapping = FindHandlesWithHome(62, 4);
+		std::vector<cct::UInt64> displaced = FindHandlesWithHome(1, 2);
+
+		HandleTable<cct::UInt64> table;
+		std::unordered_map<cct::UInt64, cct::UInt64> expected;
+		VMI_CHECK(table.Insert(atStart, 1));
+		expected[atStart] = 1;
+		for (cct::UInt64 handle : wrapping)
+		{
+			VMI_CHECK(table.Insert(handle, handle * 10));
+			expected[handle] = handle * 10;
+		}
+		for (cct::UInt64 handle : displaced)
+		{
+			VMI_CHECK(table.Insert(handle, handle * 10));
+			expected[handle] = handle * 10;
+		}
+		VMI_CHECK(Contains(table, expected));
+
+		// Replacing keeps a single entry
+		VMI_CHECK(!table.Insert(wrapping[2], 7));
+		expected[wrapping[2]] = 7;
+		VMI_CHECK(Contains(table, expected));
+
+		// Head of the run, at the last position, then entries past the wraparound
+		for (cct::UInt64 handle : { wrapping[0], wrapping[3], displaced[0] })
+		{
+			VMI_CHECK(table.Erase(handle));
+			VMI_CHECK(!table.Erase(handle));
+			VMI_CHECK(table.Find(handle) == nullptr);
+			expected.erase(handle);
+			VMI_CHECK(Contains(table, expected));
+		}
+
+		for (cct::UInt64 handle : { displaced[0], wrapping[0], wrapping[3] })
+		{
+			VMI_CHECK(table.Insert(handle, handle + 1));
+			expected[handle] = handle + 1;
+			VMI_CHECK(Contains(table, expected));
+		}
+
+		for (auto [handle, value] : std::unordered_map(expected))
+		{
+			VMI_CHECK(table.Erase(handle));
+			expected.erase(handle);
+			VMI_CHECK(Contains(table, expected));
+		}
+		VMI_CHECK(table.Find(wrapping[1]) == nullptr);
+		return true;
+	}
+
+	bool TestAgainstUnorderedMap()
+	{
+		HandleTable<cct::UInt64> table;
+		std::unordered_map<cct::UInt64, cct::UInt64> expected;
+		std::mt19937_64 random(42);
+		for (cct::UInt64 i = 0; i < 200000; ++i)
+		{
+			// Page aligned handles, like the addresses drivers hand out, in a range small enough to collide
+			cct::UInt64 handle = (random() % 3000) * 0x1000;
+			switch (random() % 3)
+			{
+			case 0:
+				VMI_CHECK(table.Insert(handle, i) == expected.insert_or_assign(handle, i).second);
+				break;
+			case 1:
+				VMI_CHECK(table.Erase(handle) == (expected.erase(handle) == 1));
+				break;
+			default:
+			{
+				const cct::UInt64* found = table.Find(handle);
+				auto it = expected.find(handle);
+				VMI_CHECK((found != nullptr) == (it != expected.end()));
+				VMI_CHECK(!found || *found == it->second);
+				break;
+			}
+			}
+			VMI_CHECK(table.GetSize() == expected.size());
+		}
+		VMI_CHECK(Contains(table, expected));
+
+		table.Clear();
+		VMI_CHECK(table.GetSize() == 0 && table.Find(0x1000) == nullptr && !table.Erase(0x1000));
+		return true;
+	}
+}
+
+int main()
+{
+	bool succeeded = TestCollisionsAndWraparound();
+	succeeded &= TestAgainstUnorderedMap();
+	return succeeded ? 0 : 1;
+}
@@ -31,10 +31,231 @@ EXCLUDE = {
         "vkDestroyDevice",
     ],
     "device": [
-        "vkQueuePresentKHR"
+        "vkQueuePresentKHR",
+        "vkQueueSubmit",
+        "vkQueueSubmit2",
+        "vkWaitForFences",
+        "vkQueueWaitIdle",
+        "vkDeviceWaitIdle",
+        "vkAcquireNextImageKHR",
+        "vkAcquireNextImage2KHR",
+        "vkDestroySwapchainKHR",
     ]
 }
 
+# Extension aliases of hand written commands, routed to the same function. The dispatch
+# table falls back to the alias when the device does not expose the core name.
+HANDWRITTEN_ALIASES = {
+    "vkQueueSubmit2KHR": "vkQueueSubmit2",
+}
+
+# -----------------------------------------------------------------------------
+# Capture categories (CaptureCategory in VMI/CaptureCategory.hpp)
+#
+# A command is routed through the layer when one of its categories is enabled at
+# startup, otherwise vkGet*ProcAddr returns the next layer's function directly.
+# The commands that create and destroy a handle type must share their categories:
+# the allocation callbacks are only substituted on routed commands.
+# assign_capture_categories gives each of them the categories of the whole group
+# and check_capture_categories fails the generation when they differ.
+# vkDestroySwapchainKHR is the exception, it is always routed to keep the frame
+# timelines in sync and looks up how vkCreateSwapchainKHR was routed.
+# -----------------------------------------------------------------------------
+
+SUBMISSION_COMMANDS = [
+    "vkQueueSubmit",
+    "vkQueueSubmit2",
+    "vkWaitForFences",
+    "vkQueueWaitIdle",
+    "vkDeviceWaitIdle",
+    "vkAcquireNextImageKHR",
+    "vkAcquireNextImage2KHR",
+]
+
+HANDWRITTEN_CATEGORIES = {name: ["Core"] for name in EXCLUDE["instance"] + EXCLUDE["device"] if name not in SUBMISSION_COMMANDS}
+# They send their vulkan_event like the generated wrappers, api_trace routes them too
+HANDWRITTEN_CATEGORIES.update({name: ["ApiTrace", "Submission"] for name in SUBMISSION_COMMANDS})
+
+MEMORY_COMMANDS = [
+    "vkAllocateMemory",
+    "vkFreeMemory",
+    "vkMapMemory",
+    "vkUnmapMemory",
+    "vkBindBufferMemory",
+    "vkBindBufferMemory2",
+    "vkBindImageMemory",
+    "vkBindImageMemory2",
+    "vkCreateBuffer",
+    "vkDestroyBuffer",
+    "vkCreateImage",
+    "vkDestroyImage",
+    "vkGetBufferMemoryRequirements",
+    "vkGetBufferMemoryRequirements2",
+    "vkGetImageMemoryRequirements",
+    "vkGetImageMemoryRequirements2",
+]
+
+COMMAND_BUFFER_COMMANDS = [
+    "vkAllocateCommandBuffers",
+    "vkFreeCommandBuffers",
+    "vkBeginCommandBuffer",
+    "vkEndCommandBuffer",
+    "vkResetCommandBuffer",
+]
+
+# -----------------------------------------------------------------------------
+# Post call hooks
+#
+# Once the next layer returned, the wrappers of these commands call
+# Post<Command>(result, <parameters>), written by hand to feed the ObjectTracker
+# (Src/VMI/ObjectLifetime.cpp) and the MemoryAdvisor (Src/VMI/VkAllocateMemory.cpp)
+# of the device. LIFETIME_COMMANDS are also routed by the Lifetime category.
+# -----------------------------------------------------------------------------
+
+LIFETIME_COMMANDS = [
+    "vkAllocateMemory",
+    "vkFreeMemory",
+    "vkCreateBuffer",
+    "vkDestroyBuffer",
+    "vkCreateImage",
+    "vkDestroyImage",
+    "vkCreateCommandPool",
+    "vkDestroyCommandPool",
+    "vkCreateDescriptorPool",
+    "vkDestroyDescriptorPool",
+    "vkCreateQueryPool",
+    "vkDestroyQueryPool",
+    "vkCreateGraphicsPipelines",
+    "vkCreateComputePipelines",
+    "vkCreateRayTracingPipelinesKHR",
+    "vkCreateRayTracingPipelinesNV",
+    "vkCreateExecutionGraphPipelinesAMDX",
+    "vkDestroyPipeline",
+]
+
+MEMORY_ADVISOR_COMMANDS = [
+    "vkBindBufferMemory",
+    "vkBindBufferMemory2",
+    "vkBindImageMemory",
+    "vkBindImageMemory2",
+]
+
+POST_CALL_HOOK_COMMANDS = LIFETIME_COMMANDS + MEMORY_ADVISOR_COMMANDS
+
+def get_post_call_hook(cmd):
+    return f"Post{cmd['name'][2:]}"
+
+ALWAYS_ROUTED_COMMANDS = ["vkDestroySwapchainKHR"]
+
+def get_param_handle_type(param, handles):
+    """Returns the handle type of a parameter and whether the command writes it, None when it is not a handle."""
+    tokens = param.replace("*", " * ").split()
+    is_const = tokens[0] == "const"
+    if is_const:
+        tokens = tokens[1:]
+    if tokens[0] not in handles:
+        return None
+    return tokens[0], not is_const and "*" in tokens
+
+def get_lifetime_handle_type(cmd, handles):
+    """Returns the handle type a command creates or destroys, None for the other commands."""
+    if cmd["name"].startswith(("vkCreate", "vkAllocate", "vkRegister")):
+        handle_type = get_param_handle_type(cmd["params"][-1], handles)
+        return handle_type[0] if handle_type and handle_type[1] else None
+    if cmd["name"].startswith(("vkDestroy", "vkFree")):
+        # The destroyed handles come after their parent, vkDestroyInstance only has its own
+        handle_types = [handle_type[0] for handle_type in (get_param_handle_type(p, handles) for p in cmd["params"]) if handle_type]
+        return handle_types[-1] if handle_types else None
+    return None
+
+def get_command_categories(cmd):
+    if cmd["name"] in HANDWRITTEN_CATEGORIES:
+        return HANDWRITTEN_CATEGORIES[cmd["name"]]
+    categories = ["ApiTrace"]
+    if "pAllocator" in cmd["param_names"]:
+        categories.append("HostMemory")
+    if cmd["name"] in MEMORY_COMMANDS:
+        categories.append("Memory")
+    if cmd["name"].startswith("vkCmd") or cmd["name"] in COMMAND_BUFFER_COMMANDS:
+        categories.append("CommandBuffer")
+    if cmd["name"] in LIFETIME_COMMANDS:
+        categories.append("Lifetime")
+    return categories
+
+def group_by_lifetime_handle_type(registry_data):
+    groups = {}
+    handles = set(registry_data["handles"])
+    for cmd in registry_data["commands"].values():
+        handle_type = get_lifetime_handle_type(cmd, handles)
+        if handle_type:
+            groups.setdefault(handle_type, []).append(cmd)
+    return groups
+
+def assign_capture_categories(registry_data):
+    """Gives every command its categories, the creators and destroyers of a handle type get the categories of all of them."""
+    for cmd in registry_data["commands"].values():
+        cmd["capture_categories"] = get_command_categories(cmd)
+    for cmds in group_by_lifetime_handle_type(registry_data).values():
+        # Hand written commands are routed by their own categories, check_capture_categories catches a mismatch
+        cmds = [cmd for cmd in cmds if cmd["name"] not in HANDWRITTEN_CATEGORIES]
+        categories = []
+        for cmd in cmds:
+            categories += [c for c in cmd["capture_categories"] if c not in categories]
+        for cmd in cmds:
+            cmd["capture_categories"] = categories
+    check_capture_categories(registry_data)
+
+def check_capture_categories(registry_data):
+    for handle_type, cmds in group_by_lifetime_handle_type(registry_data).items():
+        cmds = [cmd for cmd in cmds if cmd["name"] not in ALWAYS_ROUTED_COMMANDS]
+        if len({frozenset(get_capture_categories(cmd)) for cmd in cmds}) > 1:
+            details = ", ".join(f"{cmd['name']}: {'|'.join(get_capture_categories(cmd))}" for cmd in cmds)
+            raise RuntimeError(f"The commands creating and destroying {handle_type} are routed by different categories ({details})")
+
+def get_capture_categories(cmd):
+    return cmd["capture_categories"]
+
+# -----------------------------------------------------------------------------
+# Perfect hash for vkGetInstanceProcAddr / vkGetDeviceProcAddr
+# -----------------------------------------------------------------------------
+
+def proc_addr_hash(name, seed):
+    """FNV-1a, seeded. Must match HashProcAddrName() in VMI/ProcAddrTable.hpp."""
+    h = (2166136261 ^ seed) & 0xFFFFFFFF
+    for byte in name.encode("ascii"):
+        h ^= byte
+        h = (h * 16777619) & 0xFFFFFFFF
+    return h
+
+def build_perfect_hash(names):
+    """
+    Hash and displace: names are spread into buckets by a first hash, then each bucket,
+    largest first, gets the first displacement (seed of the second hash) that moves all
+    its names into free slots. Returns the displacement of each bucket and the name of each slot.
+    """
+    slot_count = len(names)
+    bucket_count = max(1, (len(names) + 3) // 4)
+    buckets = [[] for _ in range(bucket_count)]
+    for name in names:
+        buckets[proc_addr_hash(name, 0) % bucket_count].append(name)
+
+    slots = [None] * slot_count
+    displacements = [0] * bucket_count
+    for bucket_index in sorted(range(bucket_count), key=lambda i: -len(buckets[i])):
+        bucket = buckets[bucket_index]
+        if not bucket:
+            continue
+        for seed in range(1, 0x10000):
+            positions = [proc_addr_hash(name, seed) % slot_count for name in bucket]
+            if len(set(positions)) == len(positions) and all(slots[p] is None for p in positions):
+                break
+        else:
+            raise RuntimeError(f"Could not find a displacement for bucket {bucket_index}")
+        displacements[bucket_index] = seed
+        for name, position in zip(bucket, positions):
+            slots[position] = name
+    return displacements, slots
+
 # -----------------------------------------------------------------------------
 # Vulkan Registry Parser
 # -----------------------------------------------------------------------------
@@ -279,7 +500,9 @@ class CppCommandGenerator(BaseGenerator):
             f.write('#include "VMI/VulkanMemoryInspector.hpp"\n')
             f.write('#include "VMI/VulkanFunctions.hpp"\n')
             f.write('#include "VMI/Bindings.hpp"\n\n')
-            f.write('#include "VMI/VulkanStructToJson.hpp"\n\n')
+            f.write('#include "VMI/VulkanStructToJson.hpp"\n')
+            f.write('#include "VMI/ProcAddrTable.hpp"\n\n')
+            f.write("#include <array>\n\n")
             f.write("// Core commands\n\n")
             for feature, cmds in self.registry_data["features"].items():
                 self._generate_cpp_code([feature], cmds, f)
@@ -287,6 +510,7 @@ class CppCommandGenerator(BaseGenerator):
             for ext, data in self.registry_data["extensions"].items():
                 self._generate_cpp_code(get_defines_list(ext, data), data["commands"], f)
 
+            self._generate_proc_addr_table(f)
             self._generate_get_proc_addr_code('VkDevice', f)
             self._generate_get_proc_addr_code('VkInstance', f)
 
@@ -325,6 +549,12 @@ class CppCommandGenerator(BaseGenerator):
                 if pname != cmd['param_names'][-1]:
                     json_data += ", "
             json_data += "}"
+            # Host allocations made by the driver are attributed to the command that passed the layer callbacks
+            uses_allocator = "pAllocator" in cmd['param_names']
+            call_params = ["&allocationCallbacks" if pname == "pAllocator" else pname for pname in cmd['param_names']]
+            allocation_callbacks = f'VMI_GET_ALLOCATION_CALLBACKS(allocationCallbacks, "{cmd["name"]}");\n\t' if uses_allocator else ""
+            hook_params = (["result"] if cmd["return_value"] != None else []) + cmd['param_names']
+            post_call_hook = f"{get_post_call_hook(cmd)}({', '.join(hook_params)});\n\t" if cmd["name"] in POST_CALL_HOOK_COMMANDS else ""
             f.write(f"{cmd['prototype']}\n{{\n")
             f.write(
 f"""	const auto* dp = VulkanMemoryInspector::GetInstance()->Get{cmd["kind"].title()}DispatchTable(GetKey({cmd['param_names'][0]}));
@@ -333,51 +563,78 @@ f"""	const auto* dp = VulkanMemoryInspector::GetInstance()->Get{cmd["kind"].titl
 		CCT_ASSERT_FALSE("Could not get the device dispatch table");
 		return {"VK_ERROR_INVALID_EXTERNAL_HANDLE" if cmd['return_value'] else ''};
 	}}
-	{"auto result = " if cmd["return_value"] != None else ""}dp->{cmd['name'][2:]}({', '.join(cmd['param_names'])});
-	VulkanEvent vmiEvent = {{
-		.id = 0,
-		.timestamp = GetCurrentTimeStamp(),
-		.frameNumber = VulkanMemoryInspector::GetInstance()->GetFrameIndex(),
-		.functionName = "{cmd['name']}",
-		.parameters = nlohmann::json{json_data}.dump(),
-		.resultCode = {"static_cast<cct::Int32>(result)" if cmd["return_value"] != None else "0"},
-		.threadId = GetCurrentThreadId(),
-    }};
-	auto buff = Serialize(vmiEvent);
-	VulkanMemoryInspector::GetInstance()->Send(buff);
+	{allocation_callbacks}{"auto result = " if cmd["return_value"] != None else ""}dp->{cmd['name'][2:]}({', '.join(call_params)});
+	{post_call_hook}if (VulkanMemoryInspector::GetInstance()->ShouldTrace())
+		VulkanMemoryInspector::GetInstance()->SendVulkanEvent("{cmd['name']}", nlohmann::json{json_data}.dump(), {"static_cast<cct::Int32>(result)" if cmd["return_value"] != None else "0"});
 	{"return result;" if cmd["return_value"] != None else ""};
 }}\n\n""")
         if defines and cmds:
             f.write(f"#endif // {defines_str}\n\n")
 
 
-    def _generate_get_proc_addr_code(self, object_type, f):
-        function_name = "vkGetDeviceProcAddr" if object_type == "VkDevice" else "vkGetInstanceProcAddr"
-        f.write(f"PFN_vkVoidFunction {function_name}({object_type} instance, const char* pName)\n")
-        f.write("{\n")
+    def _collect_proc_addr_commands(self):
+        """Returns every command with the preprocessor condition it is compiled under."""
+        commands = []
         for feature, cmds in self.registry_data["features"].items():
             defines_list = [feature]
             if feature in self.registry_data["platform_defines"]:
                 defines_list.append(self.registry_data["platform_defines"][feature])
-            if defines_list and cmds:
-                f.write(f"#if {' && '.join(defines_list)}\n")
             for cmd in cmds:
-                f.write(f'\tif (strcmp(pName, "{cmd["name"]}") == 0)\n\t\treturn reinterpret_cast<PFN_vkVoidFunction>({cmd["name"]});\n')
-            if defines_list and cmds:
-                f.write(f"#endif // {' && '.join(defines_list)}\n")
+                commands.append((cmd, " && ".join(defines_list)))
         for ext, data in self.registry_data["extensions"].items():
-            defines_list = get_defines_list(ext, data)
-            if defines_list and data["commands"]:
-                f.write(f"#if {' && '.join(defines_list)}\n")
+            defines_list = [str(d) for d in get_defines_list(ext, data) if d]
             for cmd in data["commands"]:
-                f.write(f'\tif (strcmp(pName, "{cmd["name"]}") == 0)\n\t\treturn reinterpret_cast<PFN_vkVoidFunction>({cmd["name"]});\n')
-            if defines_list and data["commands"]:
-                f.write(f"#endif // {' && '.join(defines_list)}\n")
-        f.write(f"""
-    const auto* dp = VulkanMemoryInspector::GetInstance()->Get{object_type[2:]}DispatchTable(GetKey(instance));
-    if (!dp)
-        return nullptr;
-    return dp->{function_name[2:]}(instance, pName);
+                commands.append((cmd, " && ".join(defines_list)))
+        return commands
+
+    def _generate_proc_addr_table(self, f):
+        commands = {cmd["name"]: (cmd, guard) for cmd, guard in self._collect_proc_addr_commands()}
+        for alias, name in HANDWRITTEN_ALIASES.items():
+            if name in commands:
+                commands[alias] = commands[name]
+        displacements, slots = build_perfect_hash(list(commands.keys()))
+
+        f.write("namespace\n{\n")
+        f.write(f"\tconstexpr std::array<cct::UInt16, {len(displacements)}> ProcAddrDisplacements = {{\n")
+        for i in range(0, len(displacements), 16):
+            f.write("\t\t" + ", ".join(str(d) for d in displacements[i:i + 16]) + ",\n")
+        f.write("\t};\n\n")
+
+        f.write(f"\tconst std::array<ProcAddrEntry, {len(slots)}> ProcAddrEntries = {{{{\n")
+        for name in slots:
+            cmd, guard = commands[name]
+            is_instance = "true" if cmd["kind"] == "instance" else "false"
+            categories = " | ".join(f"CaptureCategoryFlags(CaptureCategory::{c})" for c in get_capture_categories(cmd))
+            f.write(f"#if {guard}\n")
+            f.write(f'\t\t{{ "{name}", reinterpret_cast<PFN_vkVoidFunction>(&{cmd["name"]}), {is_instance}, {categories} }},\n')
+            f.write("#else\n")
+            f.write(f'\t\t{{ "{name}", nullptr, {is_instance}, {categories} }},\n')
+            f.write(f"#endif // {guard}\n")
+        f.write("\t}};\n")
+        f.write("}\n\n")
+
+        f.write("const ProcAddrEntry* FindProcAddrEntry(std::string_view name)\n{\n")
+        f.write("\treturn FindProcAddrEntry(ProcAddrEntries, ProcAddrDisplacements, name);\n}\n\n")
+
+    def _generate_get_proc_addr_code(self, object_type, f):
+        function_name = "vkGetDeviceProcAddr" if object_type == "VkDevice" else "vkGetInstanceProcAddr"
+        # vkGetDeviceProcAddr must not hand out instance level commands, the next layer answers for them
+        skip_instance = " && !entry->isInstanceCommand" if object_type == "VkDevice" else ""
+        f.write(f"PFN_vkVoidFunction {function_name}({object_type} instance, const char* pName)\n")
+        f.write(f"""{{
+	const ProcAddrEntry* entry = FindProcAddrEntry(pName);
+	if (entry && entry->function{skip_instance} && (entry->categories & GetStartupCaptureCategories()) != 0)
+	{{
+		if (instance || HasCaptureCategory(entry->categories, CaptureCategory::Core))
+			return entry->function;
+	}}
+	if (!instance)
+		return nullptr;
+
+	const auto* dp = VulkanMemoryInspector::GetInstance()->Get{object_type[2:]}DispatchTable(GetKey(instance));
+	if (!dp)
+		return nullptr;
+	return dp->{function_name[2:]}(instance, pName);
 }}\n\n""")
 
 class HppCommandGenerator(BaseGenerator):
@@ -430,6 +687,9 @@ class HppCommandGenerator(BaseGenerator):
             for cmd in cmds:
                 if cmd["kind"] == "device":
                     f.write(f'\t\tthis->{cmd["name"][2:]} = reinterpret_cast<PFN_{cmd["name"]}>(procAddr(device, "{cmd["name"]}"));\n')
+                    for alias in (alias for alias, name in HANDWRITTEN_ALIASES.items() if name == cmd["name"]):
+                        f.write(f'\t\tif (!this->{cmd["name"][2:]})\n')
+                        f.write(f'\t\t\tthis->{cmd["name"][2:]} = reinterpret_cast<PFN_{cmd["name"]}>(procAddr(device, "{alias}"));\n')
             f.write(f"#endif // {feature}\n")
         for ext, data in self.registry_data["extensions"].items():
             defines_list = get_defines_list(ext, data)
@@ -469,6 +729,9 @@ class HppCommandGenerator(BaseGenerator):
             return_value = cmd['return_value'] if cmd['return_value'] else 'void'
             prototype = cmd["name"] + "(" + ", ".join(cmd["params"]) + ")"
             f.write(f"VMI_EXPORT {return_value} VKAPI_CALL {prototype};\n")
+            if cmd["name"] in POST_CALL_HOOK_COMMANDS:
+                hook_params = ([f"{return_value} result"] if cmd["return_value"] else []) + cmd["params"]
+                f.write(f"void {get_post_call_hook(cmd)}({', '.join(hook_params)});\n")
         if defines and cmds:
             f.write(f"#endif // {defines_str}\n\n")
 
@@ -615,6 +878,7 @@ def main():
     # Parse the Vulkan registry XML.
     parser = VulkanRegistryParser(xml_vk_file, xml_video_file)
     registry_data = parser.parse()
+    assign_capture_categories(registry_data)
 
     # Generate command header and source files (existing functionality).
     hpp_generator = GeneratorFactory.get_generator("hpp", registry_data)
@@ -75,4 +75,14 @@ target("vmi-layer")
         ]], lib_path)
 
         io.writefile("VK_LAYER_vmi.json", json_content)
-    end)
\ No newline at end of file
+    end)
+
+target("vmi-layer-tests")
+    set_kind("binary")
+    set_default(false)
+    set_languages("cxx20")
+    add_files("Tests/*.cpp")
+    add_includedirs("Include")
+    add_packages("vulkan-headers", "concerto-core", "vulkan-utility-libraries")
+    add_defines("VK_NO_PROTOTYPES")
+    add_tests("default")